@@ -0,0 +1,163 @@
+#include "clock.h"
+#include "config.h"
+#include "log.h"
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <time.h>
+
+using namespace sylar;
+
+namespace {
+
+static std::atomic<base::CachedClock::Source> s_source {base::CachedClock::Source::kMonotonic};
+
+/// @brief TSC 的锚点每隔多久与 CLOCK_MONOTONIC 重新对齐
+static constexpr std::chrono::seconds kTscReanchorInterval {1};
+
+thread_local static bool tl_cached = false;
+thread_local static base::CachedClock::time_point tl_now {};
+
+thread_local static uint64_t tl_tsc_anchor = 0;
+thread_local static base::CachedClock::time_point tl_tsc_anchor_tp {};
+thread_local static base::CachedClock::time_point tl_tsc_last {};
+
+static base::CachedClock::time_point ReadClock(clockid_t clock_id) {
+	struct ::timespec ts;
+	::clock_gettime(clock_id, &ts);
+	return base::CachedClock::time_point(std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+}
+
+static inline uint64_t ReadTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/// @brief 以 CLOCK_MONOTONIC 校准的 TSC 频率，首次使用时测量约 5ms
+static double GetNsPerTick() {
+	static const double ns_per_tick = []() {
+		const auto begin_tp = ReadClock(CLOCK_MONOTONIC);
+		const uint64_t begin_tsc = ReadTsc();
+		auto end_tp = begin_tp;
+		while (end_tp - begin_tp < std::chrono::milliseconds(5)) {
+			end_tp = ReadClock(CLOCK_MONOTONIC);
+		}
+		const uint64_t end_tsc = ReadTsc();
+		return static_cast<double>(std::chrono::nanoseconds(end_tp - begin_tp).count())
+				/ static_cast<double>(end_tsc - begin_tsc);
+	}();
+	return ns_per_tick;
+}
+
+static base::CachedClock::time_point ReadTscClock() {
+	const double ns_per_tick = GetNsPerTick();
+	const uint64_t tsc = ReadTsc();
+	const uint64_t elapsed = tsc - tl_tsc_anchor;
+	base::CachedClock::time_point tp;
+	if (tl_tsc_anchor == 0 || tsc < tl_tsc_anchor
+			|| static_cast<double>(elapsed) * ns_per_tick >= std::chrono::nanoseconds(kTscReanchorInterval).count())
+	{
+		// 定期与 CLOCK_MONOTONIC 对齐，避免校准误差累积
+		tl_tsc_anchor_tp = ReadClock(CLOCK_MONOTONIC);
+		tl_tsc_anchor = ReadTsc();
+		tp = tl_tsc_anchor_tp;
+	} else {
+		tp = tl_tsc_anchor_tp + std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(elapsed) * ns_per_tick));
+	}
+	// 重新对齐时可能略早于上一次的读数
+	if (tp < tl_tsc_last) {
+		tp = tl_tsc_last;
+	}
+	tl_tsc_last = tp;
+	return tp;
+}
+
+static base::CachedClock::Source ParseSource(const std::string& name) {
+	if (name == "coarse") {
+		return base::CachedClock::Source::kMonotonicCoarse;
+	} else if (name == "tsc") {
+		if (base::CachedClock::IsTscSupported()) {
+			return base::CachedClock::Source::kTsc;
+		}
+		SYLAR_LOG_WARN(SYLAR_SYS_LOGGER()) << "invariant TSC is unsupported, clock falls back to monotonic" << std::endl;
+	} else if (name != "monotonic") {
+		SYLAR_LOG_WARN(SYLAR_SYS_LOGGER()) << "unknown clock source " << name << ", use monotonic" << std::endl;
+	}
+	return base::CachedClock::Source::kMonotonic;
+}
+
+struct __InitClockConfigHelper {
+	__InitClockConfigHelper() {
+		auto& config = base::Singleton<base::ConfigManager>::GetInstance();
+
+		auto source = config.AddOrUpdate<std::string>("clock.source",
+				"monotonic", "clock behind the cached per-thread time: monotonic, coarse (CLOCK_MONOTONIC_COARSE, tick resolution) or tsc (invariant TSC calibrated against monotonic)");
+		source->AddMonitor([](const std::string&, const std::string& now) {
+			s_source.store(ParseSource(now), std::memory_order::memory_order_relaxed);
+		});
+	}
+};
+
+static __InitClockConfigHelper s_init_clock_config_helper {};
+
+} // namespace
+
+base::CachedClock::time_point base::CachedClock::Now() {
+	if (tl_cached) {
+		return tl_now;
+	}
+	return Read(s_source.load(std::memory_order::memory_order_relaxed));
+}
+
+base::CachedClock::time_point base::CachedClock::Refresh() {
+	tl_now = Read(s_source.load(std::memory_order::memory_order_relaxed));
+	return tl_now;
+}
+
+void base::CachedClock::SetThreadCached(bool enable) {
+	tl_cached = enable;
+	if (enable) {
+		Refresh();
+	}
+}
+
+std::time_t base::CachedClock::WallTime() {
+	struct ::timespec ts;
+	::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+	return ts.tv_sec;
+}
+
+base::CachedClock::time_point base::CachedClock::Read(Source source) {
+	switch (source) {
+	case Source::kMonotonicCoarse:
+		return ReadClock(CLOCK_MONOTONIC_COARSE);
+	case Source::kTsc:
+		return ReadTscClock();
+	case Source::kMonotonic:
+	default:
+		return ReadClock(CLOCK_MONOTONIC);
+	}
+}
+
+bool base::CachedClock::IsTscSupported() {
+#if defined(__x86_64__) || defined(__i386__)
+	static const bool supported = []() {
+		std::ifstream cpuinfo("/proc/cpuinfo");
+		std::string line;
+		while (std::getline(cpuinfo, line)) {
+			if (line.compare(0, 5, "flags") == 0) {
+				return line.find(" constant_tsc") != std::string::npos
+					&& line.find(" nonstop_tsc") != std::string::npos;
+			}
+		}
+		return false;
+	}();
+	return supported;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+
+namespace sylar {
+namespace base {
+
+/// @brief 按线程缓存的单调时钟，与 std::chrono::steady_clock 共用时间起点
+///
+///		   - 启用缓存的线程(调度线程)在每次取得任务及每次 poller 返回时调用 Refresh，
+///		     其间的 Now 返回缓存值，可能落后于当前任务的整个运行时间，
+///		     仅适用于比较到期时间等可容忍该误差的场合；由相对时长计算到期时间时应使用 Refresh
+///		   - 未启用缓存的线程每次 Now 均读取时钟
+///		   - 时钟源由配置 clock.source 选择: monotonic、coarse(CLOCK_MONOTONIC_COARSE)
+///		     或 tsc(不支持 invariant TSC 时退回 monotonic)
+class CachedClock {
+public:
+	using duration = std::chrono::steady_clock::duration;
+	using time_point = std::chrono::steady_clock::time_point;
+
+	enum class Source : int {
+		kMonotonic,
+		kMonotonicCoarse,
+		kTsc
+	};
+
+	/// @brief 当前线程缓存的时间，未启用缓存时读取时钟
+	static time_point Now();
+
+	/// @brief 读取时钟并更新当前线程缓存的时间
+	static time_point Refresh();
+
+	/// @brief 启用或停用当前线程的缓存，启用时立即刷新
+	static void SetThreadCached(bool enable);
+
+	/// @brief 精度为秒的系统时间，供日志使用；每次均读取 CLOCK_REALTIME_COARSE，不受缓存影响
+	static std::time_t WallTime();
+
+	/// @brief 直接读取 @a source 时钟
+	static time_point Read(Source source);
+
+	/// @brief 当前 CPU 是否提供跨核同步且频率恒定的 TSC
+	static bool IsTscSupported();
+};
+
+} // namespace base
+} // namespace sylar
@@ -52,7 +52,7 @@ std::shared_ptr<LogEvent> LogEvent::NewLogEvent(std::string msg, LogLevel::Level
     std::shared_ptr<LogEvent> new_event(new LogEvent({
 		std::shared_ptr<Logger>(nullptr),
 		std::move(oss),
-		std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()),
+		sylar::base::CachedClock::WallTime(),
 		__LINE__,
 		__FILE__,
 		sylar::base::GetTid(),
@@ -2,6 +2,7 @@
 
 #include "singleton.hpp"
 #include "this_thread.h"
+#include "clock.h"
 
 #include <mutex>
 #include <memory>
@@ -23,7 +24,7 @@
 		sylar::base::LogEventWrapper(std::shared_ptr<sylar::base::LogEvent>(new sylar::base::LogEvent({	\
 			logger,																		\
 			std::ostringstream(),														\
-			std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()),		\
+			sylar::base::CachedClock::WallTime(),										\
 			__LINE__,			\
 			__FILE__,			\
 			sylar::base::GetTid(),	\
@@ -51,7 +52,7 @@
 		sylar::base::LogEventWrapper(std::shared_ptr<sylar::base::LogEvent>(new sylar::base::LogEvent({	\
 					logger,																		\
 					std::ostringstream(),														\
-					std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()),		\
+					sylar::base::CachedClock::WallTime(),										\
 					__LINE__,			\
 					__FILE__,			\
 					sylar::base::GetTid(),	\
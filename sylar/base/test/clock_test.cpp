@@ -0,0 +1,54 @@
+#include "../clock.h"
+#include "../config.h"
+#include "../debug.h"
+#include "../log.h"
+
+#include <thread>
+
+using namespace sylar;
+
+static void SetSource(const std::string& source) {
+	base::Singleton<base::ConfigManager>::GetInstance().Find<std::string>("clock.source")->SetVal(source);
+}
+
+/// @brief 各时钟源单调不减，且与 steady_clock 相差不超过 @a tolerance
+static void CheckSource(const std::string& source, std::chrono::milliseconds tolerance) {
+	SetSource(source);
+	auto prev = base::CachedClock::Now();
+	for (int i = 0; i < 100000; ++i) {
+		auto now = base::CachedClock::Now();
+		SYLAR_ASSERT(now >= prev);
+		prev = now;
+	}
+	auto diff = std::chrono::steady_clock::now() - base::CachedClock::Now();
+	SYLAR_ASSERT(diff < tolerance && diff > -tolerance);
+}
+
+int main() {
+	CheckSource("monotonic", std::chrono::milliseconds(1));
+	CheckSource("coarse", std::chrono::milliseconds(20));
+	if (base::CachedClock::IsTscSupported()) {
+		CheckSource("tsc", std::chrono::milliseconds(1));
+	}
+	SetSource("monotonic");
+
+	// 启用缓存后 Now 在两次刷新之间保持不变
+	base::CachedClock::SetThreadCached(true);
+	auto cached = base::CachedClock::Now();
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	SYLAR_ASSERT(base::CachedClock::Now() == cached);
+	auto refreshed = base::CachedClock::Refresh();
+	SYLAR_ASSERT(refreshed - cached >= std::chrono::milliseconds(2));
+	SYLAR_ASSERT(base::CachedClock::Now() == refreshed);
+
+	// 缓存按线程独立，其他线程读取的是当前时间
+	std::thread([refreshed]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		SYLAR_ASSERT(base::CachedClock::Now() > refreshed);
+	}).join();
+
+	base::CachedClock::SetThreadCached(false);
+	SYLAR_ASSERT(base::CachedClock::Now() > refreshed);
+
+	SYLAR_LOG_INFO(SYLAR_ROOT_LOGGER()) << "clock test passed, tsc supported=" << base::CachedClock::IsTscSupported() << std::endl;
+}
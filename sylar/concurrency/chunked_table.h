@@ -0,0 +1,117 @@
+#pragma once
+
+#include <base/debug.h>
+
+#include <new>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <type_traits>
+
+namespace sylar {
+namespace concurrency {
+
+/// @brief 以较小整数为下标的分块数组
+///
+///		   - 元素按 @a ChunkSize 个一块分配，块一经分配便不再移动或释放，直至表被析构，
+///		     因此获取到的元素指针始终有效，查找只需一次原子读取，无需加锁
+///		   - 块目录的长度在构造时确定，目录本身占用 capacity / ChunkSize 个指针
+/// @tparam T  元素类型，可由 size_t 构造时以下标构造，否则默认构造
+template <typename T, size_t ChunkSize>
+class ChunkedTable {
+public:
+	/// @param capacity  可容纳的下标上限(不含)，向上取整至 @a ChunkSize 的整数倍
+	explicit ChunkedTable(size_t capacity);
+
+	~ChunkedTable() noexcept;
+
+	/// @brief 获取 @a index 对应的元素，其所在的块尚未分配时分配之
+	T* Get(size_t index);
+
+	/// @brief 获取 @a index 对应的元素，其所在的块尚未分配时返回 nullptr
+	T* Find(size_t index) const;
+
+	/// @brief 可容纳的下标上限(不含)
+	size_t Capacity() const
+	{ return chunkNum_ * ChunkSize; }
+
+private:
+	ChunkedTable(const ChunkedTable&) = delete;
+	ChunkedTable& operator=(const ChunkedTable&) = delete;
+
+	struct Chunk {
+		explicit Chunk(size_t first_index) {
+			for (size_t i = 0; i < ChunkSize; ++i) {
+				if constexpr (std::is_constructible<T, size_t>::value) {
+					new (&Item(i)) T(first_index + i);
+				} else {
+					new (&Item(i)) T();
+				}
+			}
+		}
+
+		~Chunk() noexcept {
+			for (size_t i = 0; i < ChunkSize; ++i) {
+				Item(i).~T();
+			}
+		}
+
+		T& Item(size_t i)
+		{ return reinterpret_cast<T*>(storage)[i]; }
+
+		alignas(T) unsigned char storage[sizeof(T) * ChunkSize];
+	};
+
+private:
+	size_t chunkNum_;
+	std::unique_ptr<std::atomic<Chunk*>[]> chunks_;
+};
+
+template <typename T, size_t ChunkSize>
+ChunkedTable<T, ChunkSize>::ChunkedTable(size_t capacity) {
+	chunkNum_ = (capacity + ChunkSize - 1) / ChunkSize;
+	chunks_.reset(new std::atomic<Chunk*>[chunkNum_]);
+	for (size_t i = 0; i < chunkNum_; ++i) {
+		chunks_[i].store(nullptr, std::memory_order::memory_order_relaxed);
+	}
+}
+
+template <typename T, size_t ChunkSize>
+ChunkedTable<T, ChunkSize>::~ChunkedTable() noexcept {
+	for (size_t i = 0; i < chunkNum_; ++i) {
+		delete chunks_[i].load(std::memory_order::memory_order_relaxed);
+	}
+}
+
+template <typename T, size_t ChunkSize>
+T* ChunkedTable<T, ChunkSize>::Get(size_t index) {
+	SYLAR_ASSERT_WITH_MSG(index < Capacity(), "index is out of the range of ChunkedTable");
+
+	const size_t chunk_index = index / ChunkSize;
+	Chunk* chunk = chunks_[chunk_index].load(std::memory_order::memory_order_acquire);
+	if (__builtin_expect(chunk == nullptr, 0)) {
+		// 与其他线程竞争分配，失败者释放自己的块
+		Chunk* new_chunk = new Chunk(chunk_index * ChunkSize);
+		if (chunks_[chunk_index].compare_exchange_strong(chunk, new_chunk,
+				std::memory_order::memory_order_acq_rel, std::memory_order::memory_order_acquire))
+		{
+			chunk = new_chunk;
+		} else {
+			delete new_chunk;
+		}
+	}
+	return &chunk->Item(index % ChunkSize);
+}
+
+template <typename T, size_t ChunkSize>
+T* ChunkedTable<T, ChunkSize>::Find(size_t index) const {
+	if (index >= Capacity()) {
+		return nullptr;
+	}
+
+	Chunk* chunk = chunks_[index / ChunkSize].load(std::memory_order::memory_order_acquire);
+	return chunk ? &chunk->Item(index % ChunkSize) : nullptr;
+}
+
+} // namespace concurrency
+} // namespace sylar
@@ -0,0 +1,193 @@
+#include <concurrency/context.h>
+#include <base/log.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto sys_logger = SYLAR_SYS_LOGGER();
+
+#if !defined(SYLAR_CONTEXT_UCONTEXT)
+
+extern "C" {
+
+/// @brief 保存 callee-saved 寄存器至当前栈，并将栈顶写入 *from_sp，随后切换至 to_sp 所指的栈
+void sylar_context_swap(void** from_sp, void* to_sp);
+
+}
+
+#if defined(__x86_64__)
+
+// 栈布局(自高地址至低地址): return-address, rbp, rbx, r12, r13, r14, r15, [mxcsr | x87 cw]
+__asm__(
+	".text\n"
+	".globl sylar_context_swap\n"
+	".hidden sylar_context_swap\n"
+	".type sylar_context_swap,@function\n"
+	".align 16\n"
+"sylar_context_swap:\n"
+	"	pushq %rbp\n"
+	"	pushq %rbx\n"
+	"	pushq %r12\n"
+	"	pushq %r13\n"
+	"	pushq %r14\n"
+	"	pushq %r15\n"
+	"	subq $8, %rsp\n"
+	"	stmxcsr (%rsp)\n"
+	"	fnstcw 4(%rsp)\n"
+	"	movq %rsp, (%rdi)\n"
+	"	movq %rsi, %rsp\n"
+	"	ldmxcsr (%rsp)\n"
+	"	fldcw 4(%rsp)\n"
+	"	addq $8, %rsp\n"
+	"	popq %r15\n"
+	"	popq %r14\n"
+	"	popq %r13\n"
+	"	popq %r12\n"
+	"	popq %rbx\n"
+	"	popq %rbp\n"
+	"	ret\n"
+	".size sylar_context_swap,.-sylar_context_swap\n"
+);
+
+namespace {
+
+constexpr size_t kSavedFrameSize = 8 /* fpu */ + 6 * 8 /* gprs */ + 8 /* return address */;
+
+static void* InitStackFrame(void* stack_top, cc::Context::Entry entry) {
+	auto top = reinterpret_cast<uintptr_t>(stack_top) & ~static_cast<uintptr_t>(15);
+	// 为入口函数预留一个伪返回地址，使其入口处满足 (rsp + 8) % 16 == 0
+	top -= sizeof(void*);
+	*reinterpret_cast<void**>(top) = nullptr;
+
+	auto frame = reinterpret_cast<uint64_t*>(top - kSavedFrameSize);
+	std::memset(frame, 0, kSavedFrameSize);
+	frame[0] = 0x1F80 | (static_cast<uint64_t>(0x037F) << 32);	// mxcsr, x87 control word
+	frame[7] = reinterpret_cast<uint64_t>(entry);				// return address
+	return frame;
+}
+
+} // namespace
+
+#elif defined(__aarch64__)
+
+// 栈布局(自低地址至高地址): x19-x28, x29(fp), x30(lr), d8-d15
+__asm__(
+	".text\n"
+	".globl sylar_context_swap\n"
+	".hidden sylar_context_swap\n"
+	".type sylar_context_swap,%function\n"
+	".align 4\n"
+"sylar_context_swap:\n"
+	"	sub sp, sp, #160\n"
+	"	stp x19, x20, [sp, #0]\n"
+	"	stp x21, x22, [sp, #16]\n"
+	"	stp x23, x24, [sp, #32]\n"
+	"	stp x25, x26, [sp, #48]\n"
+	"	stp x27, x28, [sp, #64]\n"
+	"	stp x29, x30, [sp, #80]\n"
+	"	stp d8, d9, [sp, #96]\n"
+	"	stp d10, d11, [sp, #112]\n"
+	"	stp d12, d13, [sp, #128]\n"
+	"	stp d14, d15, [sp, #144]\n"
+	"	mov x9, sp\n"
+	"	str x9, [x0]\n"
+	"	mov sp, x1\n"
+	"	ldp x19, x20, [sp, #0]\n"
+	"	ldp x21, x22, [sp, #16]\n"
+	"	ldp x23, x24, [sp, #32]\n"
+	"	ldp x25, x26, [sp, #48]\n"
+	"	ldp x27, x28, [sp, #64]\n"
+	"	ldp x29, x30, [sp, #80]\n"
+	"	ldp d8, d9, [sp, #96]\n"
+	"	ldp d10, d11, [sp, #112]\n"
+	"	ldp d12, d13, [sp, #128]\n"
+	"	ldp d14, d15, [sp, #144]\n"
+	"	add sp, sp, #160\n"
+	"	ret\n"
+	".size sylar_context_swap,.-sylar_context_swap\n"
+);
+
+namespace {
+
+constexpr size_t kSavedFrameSize = 160;
+
+static void* InitStackFrame(void* stack_top, cc::Context::Entry entry) {
+	auto top = reinterpret_cast<uintptr_t>(stack_top) & ~static_cast<uintptr_t>(15);
+	auto frame = reinterpret_cast<uint64_t*>(top - kSavedFrameSize);
+	std::memset(frame, 0, kSavedFrameSize);
+	frame[11] = reinterpret_cast<uint64_t>(entry);	// x30(lr)
+	return frame;
+}
+
+} // namespace
+
+#else
+#error "no assembly context backend for this architecture, configure with -DSYLAR_CONTEXT_BACKEND=ucontext"
+#endif
+
+void cc::Context::InitWithCurrent() {
+	// 当前执行流的上下文在首次 Swap 时被保存
+	sp_ = nullptr;
+}
+
+void cc::Context::Make(void* stack, size_t size, Entry entry) {
+	sp_ = InitStackFrame(static_cast<char*>(stack) + size, entry);
+}
+
+void cc::Context::Swap(Context* from, Context* to) {
+	sylar_context_swap(&from->sp_, to->sp_);
+}
+
+void* cc::Context::GetStackPointer() const {
+	return sp_;
+}
+
+const char* cc::Context::BackendName() {
+	return "asm";
+}
+
+#else	// SYLAR_CONTEXT_UCONTEXT
+
+void cc::Context::InitWithCurrent() {
+	if (::getcontext(&ctx_)) {
+		SYLAR_LOG_FATAL(sys_logger) << "fail to invoke ::getcontext, about to abort!" << std::endl;
+		std::abort();
+	}
+}
+
+void cc::Context::Make(void* stack, size_t size, Entry entry) {
+	ctx_ = {};
+	InitWithCurrent();
+
+	ctx_.uc_link = nullptr;
+	ctx_.uc_stack.ss_sp = stack;
+	ctx_.uc_stack.ss_size = size;
+	::makecontext(&ctx_, entry, 0);
+}
+
+void cc::Context::Swap(Context* from, Context* to) {
+	if (::swapcontext(&from->ctx_, &to->ctx_)) {
+		SYLAR_LOG_FATAL(sys_logger) << "fail to invoke ::swapcontext, about to abort!" << std::endl;
+		std::abort();
+	}
+}
+
+void* cc::Context::GetStackPointer() const {
+#if defined(__x86_64__)
+	return reinterpret_cast<void*>(ctx_.uc_mcontext.gregs[REG_RSP]);
+#elif defined(__aarch64__)
+	return reinterpret_cast<void*>(ctx_.uc_mcontext.sp);
+#else
+	return nullptr;
+#endif
+}
+
+const char* cc::Context::BackendName() {
+	return "ucontext";
+}
+
+#endif
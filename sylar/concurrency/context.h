@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(SYLAR_CONTEXT_UCONTEXT)
+#include <ucontext.h>
+#endif
+
+namespace sylar {
+namespace concurrency {
+
+/// @brief 协程执行上下文，屏蔽不同的上下文切换后端
+///
+///		   - 默认后端：手写汇编(x86-64 / aarch64)，仅保存 callee-saved 寄存器，
+///		     切换过程不陷入内核
+///		   - ucontext 后端：定义 SYLAR_CONTEXT_UCONTEXT 时启用，作为不支持的体系结构的回退，
+///		     每次 swapcontext 都会产生一次 rt_sigprocmask 系统调用
+class Context final {
+public:
+	using Entry = void (*)();
+
+	Context() = default;
+
+	/// @brief 以当前线程的执行流初始化上下文，用于main协程
+	void InitWithCurrent();
+
+	/// @brief 在 @a stack 上创建一个以 @a entry 为入口的上下文
+	/// @param stack  栈的低地址
+	/// @param size  栈大小
+	/// @param entry  入口函数，不允许返回
+	void Make(void* stack, size_t size, Entry entry);
+
+	/// @brief 保存当前上下文至 @a from，并切换至 @a to
+	static void Swap(Context* from, Context* to);
+
+	/// @brief 获取处于挂起状态的上下文的栈顶指针
+	void* GetStackPointer() const;
+
+	/// @brief 当前编译所使用的后端名称
+	static const char* BackendName();
+
+private:
+	Context(const Context&) = delete;
+	Context& operator=(const Context&) = delete;
+
+private:
+#if defined(SYLAR_CONTEXT_UCONTEXT)
+	::ucontext_t ctx_ = {};
+#else
+	void* sp_ = nullptr;
+#endif
+};
+
+} // namespace concurrency
+} // namespace sylar
@@ -1,9 +1,11 @@
 #include <base/debug.h>
+#include <base/config.h>
 #include <concurrency/coroutine.h>
 #include <concurrency/scheduler.h>
 
 #include <atomic>
 #include <memory>
+#include <cstring>
 
 using namespace sylar;
 namespace cc = concurrency;
@@ -16,6 +18,47 @@ namespace {
 static std::atomic<cc::Coroutine::CoroutineId> s_coroutine_next_id = {1};
 static std::atomic<size_t> s_coroutine_count = {0};
 
+static auto g_shared_stack_size = base::Singleton<base::ConfigManager>::GetInstance()
+		.AddOrUpdate<size_t>("coroutine.shared_stack_size", 8 * 1024 * 1024, "size of the per-thread shared coroutine stack");
+
+/// @brief 线程共享栈，供共享栈协程轮流使用
+struct SharedStack {
+	~SharedStack() noexcept {
+		cc::StackPool::Deallocate(stack);
+	}
+
+	cc::Stack stack;
+	/// @brief 其栈帧当前仍完整驻留于共享栈上的协程，用于跳过不必要的还原
+	cc::Coroutine::CoroutineId occupant = 0;
+};
+
+thread_local static SharedStack tl_shared_stack;
+
+static std::atomic<size_t> s_coroutine_recycle_cap {64};
+
+struct __InitCoroutineRecycleConfigHelper {
+	__InitCoroutineRecycleConfigHelper() {
+		auto recycle_cap = base::Singleton<base::ConfigManager>::GetInstance()
+				.AddOrUpdate<size_t>("coroutine.recycle_cap", s_coroutine_recycle_cap.load(),
+						"max terminated coroutines cached per thread for reuse");
+		recycle_cap->AddMonitor([](const size_t&, const size_t& now) {
+			s_coroutine_recycle_cap.store(now, std::memory_order::memory_order_relaxed);
+		});
+	}
+};
+
+static __InitCoroutineRecycleConfigHelper s_init_coroutine_recycle_config_helper {};
+
+/// @brief 当前线程的协程回收池，下标 0 为私有栈协程，下标 1 为共享栈协程
+thread_local static std::vector<std::shared_ptr<cc::Coroutine>> tl_recycled_coroutines[2];
+
+static SharedStack& GetThisThreadSharedStack() {
+	if (__builtin_expect(!tl_shared_stack.stack, 0)) {
+		tl_shared_stack.stack = cc::StackPool::Allocate(g_shared_stack_size->GetValue());
+	}
+	return tl_shared_stack;
+}
+
 } // namespace
 
 namespace sylar {
@@ -47,7 +90,7 @@ cc::Coroutine* cc::this_thread::GetMainCoroutine() {
 		// sets it as current coroutine for current thread
 		cc::this_thread::SetCurrentRunningCoroutine(tl_sp_main_coroutine.get());
 
-		SYLAR_LOG_FMT_DEBUG(sylar_logger, "main coroutine was constructed, id=%u\n", tl_sp_main_coroutine->GetId());
+		SYLAR_LOG_FMT_DEBUG(sylar_logger, "main coroutine was constructed, id=%lu\n", tl_sp_main_coroutine->GetId());
 	}
 	return tl_sp_main_coroutine.get();
 }
@@ -58,6 +101,35 @@ std::shared_ptr<cc::Coroutine> cc::this_thread::GetCurrentRunningCoroutine() {
 	return cc::this_thread::tl_p_cur_coroutine->shared_from_this();
 }
 
+std::shared_ptr<cc::Coroutine> cc::this_thread::AcquireCoroutine(std::function<void()> func, bool use_shared_stack) {
+	auto& recycled = tl_recycled_coroutines[use_shared_stack ? 1 : 0];
+	if (recycled.empty()) {
+		return std::make_shared<Coroutine>(std::move(func), 1024 * 1024, false, use_shared_stack);
+	}
+
+	std::shared_ptr<Coroutine> co = std::move(recycled.back());
+	recycled.pop_back();
+	co->Reset(std::move(func));
+	return co;
+}
+
+void cc::this_thread::RecycleCoroutine(std::shared_ptr<Coroutine> co) {
+	SYLAR_ASSERT(co->GetState() == Coroutine::State::kTerminal
+			|| co->GetState() == Coroutine::State::kExcept);
+
+	auto& recycled = tl_recycled_coroutines[co->IsSharedStack() ? 1 : 0];
+	if (co.use_count() != 1
+			|| recycled.size() >= s_coroutine_recycle_cap.load(std::memory_order::memory_order_relaxed))
+	{
+		// 仍被他处引用，或回收池已满
+		return;
+	}
+
+	// 释放回调函数所持有的资源
+	co->Reset(nullptr);
+	recycled.push_back(std::move(co));
+}
+
 cc::Coroutine::Coroutine()
 	: isDummyMainCoroutine_(false)
 	, id_(s_coroutine_next_id.fetch_add(1, std::memory_order::memory_order_relaxed))
@@ -66,25 +138,24 @@ cc::Coroutine::Coroutine()
 	SYLAR_ASSERT(this_thread::tl_sp_main_coroutine == nullptr);
 	SYLAR_ASSERT(this_thread::tl_p_cur_coroutine == nullptr);
 
-	if (::getcontext(&ctx_)) {
-		SYLAR_LOG_FATAL(sylar_logger) << "fail to invoke ::getcontext, about to abort!" << std::endl;
-		std::abort();
-	}
+	ctx_.InitWithCurrent();
 
 	// updates counter
 	s_coroutine_count.fetch_add(1, std::memory_order::memory_order_relaxed);
 }
 
-cc::Coroutine::Coroutine(std::function<void()> func, uint32_t stack_size, bool is_dummy_main_coroutine)
+cc::Coroutine::Coroutine(std::function<void()> func, uint32_t stack_size, bool is_dummy_main_coroutine, bool use_shared_stack)
 	: func_(std::move(func))
 	, isDummyMainCoroutine_(is_dummy_main_coroutine)
-	, stackFrame_(::malloc(stack_size))	///> FixMe
-	, stackSize_(stack_size)
+	, useSharedStack_(use_shared_stack)
+	, stack_(use_shared_stack ? Stack() : StackPool::Allocate(stack_size))
 	, id_(s_coroutine_next_id.fetch_add(1, std::memory_order::memory_order_relaxed))
 	, state_(State::kInit)
 {
 	SYLAR_ASSERT(func_ != nullptr);
-	SYLAR_ASSERT(stackFrame_ != nullptr);
+	SYLAR_ASSERT(stack_ || useSharedStack_);
+	SYLAR_ASSERT(!(useSharedStack_ && isDummyMainCoroutine_));
+	callsite_ = func_.target_type().name();
 
 	if (cc::this_thread::tl_sp_main_coroutine == nullptr) {
 		SYLAR_LOG_FATAL(sylar_logger)
@@ -93,32 +164,27 @@ cc::Coroutine::Coroutine(std::function<void()> func, uint32_t stack_size, bool i
 		std::abort();
 	}
 
-	// gets context
-	if (::getcontext(&ctx_)) {
-		SYLAR_LOG_FATAL(sylar_logger) << "fail to invoke ::getcontext, about to abort!" << std::endl;
-		std::abort();
+	// makes context, the context of shared-stack coroutine is made when it's swapped in firstly
+	if (!useSharedStack_) {
+		sampleStackUsage_ = StackPool::BeginUsageSample(stack_);
+		ctx_.Make(stack_.base, stack_.size, &Coroutine::CoroutineFunc);
 	}
 
-	// pads fields for context
-	ctx_.uc_link = nullptr;
-	ctx_.uc_stack.ss_sp = stackFrame_;
-	ctx_.uc_stack.ss_size = stackSize_;
-
-	// makes context
-	::makecontext(&ctx_, &Coroutine::CoroutineFunc, 0);
-
 	// updates counter
 	s_coroutine_count.fetch_add(1, std::memory_order::memory_order_relaxed);
 }
 
 cc::Coroutine::~Coroutine() noexcept {
-	if (stackFrame_) {
+	if (stack_ || useSharedStack_) {
 		SYLAR_ASSERT(GetState() == State::kTerminal
 				|| GetState() == State::kExec
 				|| GetState() == State::kInit);
 
-		// dealloc the associated stack
-		::free(stackFrame_);
+		if (sampleStackUsage_) {
+			StackPool::EndUsageSample(stack_, callsite_);
+		}
+		// give back the associated stack
+		StackPool::Deallocate(stack_);
 	} else {
         SYLAR_ASSERT(func_ == nullptr);
 		SYLAR_ASSERT(this->GetState() == State::kExec);
@@ -154,21 +220,22 @@ void cc::Coroutine::SwapIn() {
 	}
 
 	SYLAR_ASSERT(GetState() != State::kExec);
+	if (useSharedStack_) {
+		RestoreSharedStack();
+	}
+
 	this_thread::SetCurrentRunningCoroutine(this);
 	SetState(State::kExec);
 
 	if (!isDummyMainCoroutine_) {	// main-routine or task-routine
-		if (swapcontext(&cc::this_thread::GetSchedulingCoroutine()->ctx_, &this->ctx_)) {
-			SYLAR_LOG_FATAL(sylar_logger) << "fail to invoke ::swapcontext, about to abort!" << std::endl;
-			std::abort();
-		}
+		Context::Swap(&cc::this_thread::GetSchedulingCoroutine()->ctx_, &this->ctx_);
 	} else {	// dummy-main coroutine
-		if (swapcontext(&cc::this_thread::GetMainCoroutine()->ctx_, &this->ctx_)) {
-			SYLAR_LOG_FATAL(sylar_logger) << "fail to invoke ::swapcontext, about to abort!" << std::endl;
-			std::abort();
-		}
+		Context::Swap(&cc::this_thread::GetMainCoroutine()->ctx_, &this->ctx_);
 	}
 
+	if (useSharedStack_) {
+		SaveSharedStack();
+	}
 }
 
 void cc::Coroutine::SwapOut() {
@@ -176,38 +243,81 @@ void cc::Coroutine::SwapOut() {
 
 	if (!isDummyMainCoroutine_) {
 		this_thread::SetCurrentRunningCoroutine(cc::this_thread::GetSchedulingCoroutine());
-		if (swapcontext(&this->ctx_, &cc::this_thread::GetSchedulingCoroutine()->ctx_)) {
-			SYLAR_LOG_FATAL(sylar_logger) << "fail to invoke ::swapcontext, about to abort!" << std::endl;
-			std::abort();
-		}
+		Context::Swap(&this->ctx_, &cc::this_thread::GetSchedulingCoroutine()->ctx_);
 	} else {
 		this_thread::SetCurrentRunningCoroutine(cc::this_thread::GetMainCoroutine());
-		if (swapcontext(&this->ctx_, &cc::this_thread::GetMainCoroutine()->ctx_)) {
-			SYLAR_LOG_FATAL(sylar_logger) << "fail to invoke ::swapcontext, about to abort!" << std::endl;
-			std::abort();
-		}
+		Context::Swap(&this->ctx_, &cc::this_thread::GetMainCoroutine()->ctx_);
 	}
 }
 
 void cc::Coroutine::Reset(std::function<void()> func) {
-	SYLAR_ASSERT(stackFrame_ && stackSize_);
+	SYLAR_ASSERT(stack_ || useSharedStack_);
 	SYLAR_ASSERT(GetState() == State::kTerminal
 			|| GetState() == State::kExcept
 			|| GetState() == State::kInit)
+	// 先前的使用结束，其采样计入原回调函数的调用点
+	if (sampleStackUsage_) {
+		StackPool::EndUsageSample(stack_, callsite_);
+		sampleStackUsage_ = false;
+	}
+
 	func_ = std::move(func);
+	if (func_) {
+		callsite_ = func_.target_type().name();
+	}
 
-	ctx_ = {};
-	if (::getcontext(&ctx_)) {
-		SYLAR_LOG_FATAL(sylar_logger) << "fail to invoke ::getcontext, about to abort!" << std::endl;
-		std::abort();
+	if (useSharedStack_) {
+		// 重新绑定至下一次换入它的线程
+		boundThread_ = 0;
+		savedStack_.clear();
+	} else if (func_) {
+		// 上下文在被赋予回调函数时才创建
+		sampleStackUsage_ = StackPool::BeginUsageSample(stack_);
+		ctx_.Make(stack_.base, stack_.size, &Coroutine::CoroutineFunc);
 	}
-	ctx_.uc_stack.ss_sp = stackFrame_;
-	ctx_.uc_stack.ss_size = stackSize_;
-	::makecontext(&ctx_, &Coroutine::CoroutineFunc, 0);
 
 	state_ = State::kInit;
 }
 
+void cc::Coroutine::RestoreSharedStack() {
+	SharedStack& shared = GetThisThreadSharedStack();
+	char* stack_top = static_cast<char*>(shared.stack.base) + shared.stack.size;
+
+	if (boundThread_ == 0) {
+		// 首次换入，在当前线程的共享栈上创建上下文
+		SYLAR_ASSERT(GetState() == State::kInit);
+		boundThread_ = base::GetPthreadId();
+		ctx_.Make(shared.stack.base, shared.stack.size, &Coroutine::CoroutineFunc);
+	} else {
+		SYLAR_ASSERT_WITH_MSG(boundThread_ == base::GetPthreadId(),
+				"shared-stack coroutine must be swapped in on its bound thread");
+		if (shared.occupant != id_) {
+			SYLAR_ASSERT(savedStack_.size() <= shared.stack.size);
+			std::memcpy(stack_top - savedStack_.size(), savedStack_.data(), savedStack_.size());
+		}
+	}
+
+	shared.occupant = id_;
+}
+
+void cc::Coroutine::SaveSharedStack() {
+	SharedStack& shared = GetThisThreadSharedStack();
+	SYLAR_ASSERT(shared.occupant == id_);
+
+	if (GetState() == State::kTerminal || GetState() == State::kExcept) {
+		// 栈帧已失效，无需保存
+		savedStack_.clear();
+		shared.occupant = 0;
+		return;
+	}
+
+	char* stack_top = static_cast<char*>(shared.stack.base) + shared.stack.size;
+	char* stack_pointer = static_cast<char*>(ctx_.GetStackPointer());
+	SYLAR_ASSERT(stack_pointer >= shared.stack.base && stack_pointer <= stack_top);
+
+	savedStack_.assign(stack_pointer, stack_top);
+}
+
 bool cc::Coroutine::IsRunnable() const {
     return GetState() == State::kHold || GetState() == State::kInit || GetState() == State::kReady;
 }
@@ -225,12 +335,12 @@ void cc::Coroutine::CoroutineFunc() {
 	} catch (const std::exception& e) {
 		cur_coroutine->SetState(State::kExcept);
 		SYLAR_LOG_FMT_ERROR(sylar_logger,
-				"Coroutine %u caught a std exception: %s\nBacktrace:\n%s\n",
+				"Coroutine %lu caught a std exception: %s\nBacktrace:\n%s\n",
 				cur_coroutine->GetId(), e.what(), base::BacktraceToString(2, "\t").c_str());
 	} catch (...) {
 		cur_coroutine->SetState(State::kExcept);
 		SYLAR_LOG_FMT_ERROR(sylar_logger,
-				"Coroutine %u caught a unknown exception\nBacktrace:\n%s\n",
+				"Coroutine %lu caught a unknown exception\nBacktrace:\n%s\n",
 				cur_coroutine->GetId(), base::BacktraceToString(2, "\t").c_str());
 	}
 
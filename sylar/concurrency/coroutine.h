@@ -1,8 +1,12 @@
 #pragma once
 
+#include <concurrency/context.h>
+#include <concurrency/stack_pool.h>
+
 #include <memory>
+#include <vector>
 #include <functional>
-#include <ucontext.h>
+#include <pthread.h>
 
 namespace sylar {
 namespace concurrency {
@@ -22,6 +26,17 @@ Coroutine* GetMainCoroutine();
 /// @brief 获得当前线程在当前时刻正在执行或即将执行的协程
 std::shared_ptr<Coroutine> GetCurrentRunningCoroutine();
 
+/// @brief 从当前线程的协程回收池中取出一个协程，并以 @a func 重置；
+///		   回收池为空时新建一个协程
+/// @param use_shared_stack  是否需要共享栈协程，两类协程分别回收
+std::shared_ptr<Coroutine> AcquireCoroutine(std::function<void()> func, bool use_shared_stack = false);
+
+/// @brief 将已结束的协程归还至当前线程的协程回收池，以复用其对象及栈
+///
+///		   回收池的容量由配置项 coroutine.recycle_cap 决定，超出时协程被直接释放
+/// @pre co->GetState() == kTerminal || co->GetState() == kExcept
+void RecycleCoroutine(std::shared_ptr<Coroutine> co);
+
 } // namespace this_thread
 
 class Coroutine final : public std::enable_shared_from_this<Coroutine> {
@@ -29,7 +44,8 @@ class Coroutine final : public std::enable_shared_from_this<Coroutine> {
 	friend Coroutine* concurrency::this_thread::GetMainCoroutine();
 
 public:
-	using CoroutineId = uint32_t;
+	/// @brief 64 位递增，不会回绕，因此不会与已销毁协程的 id 重复
+	using CoroutineId = uint64_t;
 
 	enum class State : uint8_t {
 		kInit,
@@ -42,14 +58,18 @@ public:
 
 	/// @brief 创建一个协程对象
 	/// @param func  协程回调函数
-	/// @param stack_size  为该协程对象分配的栈大小
+	/// @param stack_size  为该协程对象分配的栈大小, 实际分配的大小会向上取整至栈池的尺寸类别
 	/// @param is_dummy_main_coroutine  是否为 dummy-main 协程, 若为 dummy-main 协程，
 	///									说明主线程的也作为调度线程，其实现是通过 切换至调
 	///									度协程 dummy-main 协程进行调度，当调度结束时，
 	///									应该切换回主线程的执行流，而不是调度协程，因为调
 	///									度协程就是 dummy-main 协程本身。
+	/// @param use_shared_stack  是否运行于线程共享栈上，此时 @a stack_size 被忽略。
+	///							 共享栈协程在首次换入时绑定至当前线程，此后只能在该线程上被换入；
+	///							 换出时仅将实际使用的栈空间保存至协程自身
 	/// @pre 存在main_coroutine
-	explicit Coroutine(std::function<void()> func, uint32_t stack_size = 1024 * 1024, bool is_dummy_main_coroutine = false);
+	explicit Coroutine(std::function<void()> func, uint32_t stack_size = 1024 * 1024,
+			bool is_dummy_main_coroutine = false, bool use_shared_stack = false);
 
 	~Coroutine() noexcept;
 
@@ -69,6 +89,18 @@ public:
 
 	void Reset(std::function<void()> func);
 
+	bool IsSharedStack() const
+	{ return useSharedStack_; }
+
+	/// @brief 获取该协程所绑定的线程，未绑定时返回 0
+	/// @note 只有共享栈协程会被绑定，因为其栈帧只在所属线程的共享栈上有效
+	::pthread_t GetBoundThread() const
+	{ return boundThread_; }
+
+	/// @brief 共享栈协程被换出时所保存的栈大小
+	size_t GetSavedStackSize() const
+	{ return savedStack_.size(); }
+
 	bool IsRunnable() const;
 
 public:
@@ -87,6 +119,12 @@ private:
 	void DoFunc() const
 	{ func_(); }
 
+	/// @brief 换入共享栈协程前，将其栈帧还原至当前线程的共享栈
+	void RestoreSharedStack();
+
+	/// @brief 共享栈协程被换出后，保存其在共享栈上实际使用的部分
+	void SaveSharedStack();
+
 private:
 	/// @brief 协程入口函数
 	static void CoroutineFunc();
@@ -94,10 +132,16 @@ private:
 private:
 	std::function<void()> func_ = nullptr;
 	bool isDummyMainCoroutine_;
-	void* stackFrame_ = nullptr;
-	uint32_t stackSize_ = 0;
+	bool useSharedStack_ = false;
+	Stack stack_;
+	/// @brief 调用点标识(回调函数的类型名)，用于聚合栈使用统计
+	const char* callsite_ = nullptr;
+	/// @brief 此次使用是否被栈使用统计采样
+	bool sampleStackUsage_ = false;
+	::pthread_t boundThread_ = 0;
+	std::vector<char> savedStack_;
 	CoroutineId id_;
-	::ucontext_t ctx_ = {};
+	Context ctx_;
 	State state_;
 };
 
@@ -1,13 +1,18 @@
 #include <base/log.h>
+#include <base/clock.h>
 #include <base/debug.h>
+#include <base/config.h>
 #include <concurrency/notifier.h>
 #include <concurrency/epoll_poller.h>
 #include <concurrency/timer_manager.h>
 
+#include <vector>
 #include <cstring>
+#include <algorithm>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <fcntl.h>
+#include <sched.h>
 #include <unistd.h>
 
 using namespace sylar;
@@ -16,41 +21,113 @@ namespace cc = sylar::concurrency;
 static auto sys_logger = SYLAR_SYS_LOGGER();
 static auto sylar_logger = SYLAR_ROOT_LOGGER();
 
+namespace {
+
+/// @brief 单次 epoll_wait 返回事件数的下限与初始值
+static constexpr size_t kMinEventNum = 64;
+/// @brief 连续多少次等待返回的事件数不足缓冲区的 1/4 后缩小缓冲区
+static constexpr size_t kShrinkRounds = 64;
+
+static std::atomic<size_t> s_max_event_num {4096};
+
+struct __InitEpollConfigHelper {
+	__InitEpollConfigHelper() {
+		auto& config = base::Singleton<base::ConfigManager>::GetInstance();
+
+		auto max_event_num = config.AddOrUpdate<size_t>("scheduler.epoll.max_events",
+				s_max_event_num.load(), "upper bound of the per-thread epoll_wait event buffer, which grows from 64 while waits return full batches");
+		max_event_num->AddMonitor([](const size_t&, const size_t& now) {
+			s_max_event_num.store(std::max(now, kMinEventNum), std::memory_order::memory_order_relaxed);
+		});
+	}
+};
+
+static __InitEpollConfigHelper s_init_epoll_config_helper {};
+
+/// @brief 调度线程各自的 epoll_wait 缓冲区
+///
+///		   一次等待填满缓冲区时加倍(不超过 scheduler.epoll.max_events)，
+///		   连续 kShrinkRounds 次返回的事件数不足 1/4 时减半(不低于 kMinEventNum)
+class EventBuffer {
+public:
+	EventBuffer()
+		: events_(kMinEventNum)
+		{}
+
+	epoll_event* Data()
+	{ return events_.data(); }
+
+	size_t Size() const
+	{ return events_.size(); }
+
+	void Adapt(size_t num) {
+		const size_t size = events_.size();
+		const size_t max_size = s_max_event_num.load(std::memory_order::memory_order_relaxed);
+		if (num == size && size < max_size) {
+			events_.resize(std::min(size * 2, max_size));
+			idleRounds_ = 0;
+		} else if (num <= size / 4 && size > kMinEventNum) {
+			if (++idleRounds_ >= kShrinkRounds) {
+				events_.resize(std::max(size / 2, kMinEventNum));
+				events_.shrink_to_fit();
+				idleRounds_ = 0;
+			}
+		} else {
+			idleRounds_ = 0;
+		}
+	}
+
+private:
+	std::vector<epoll_event> events_;
+	size_t idleRounds_ = 0;
+};
+
+static thread_local EventBuffer tl_event_buffer;
+
+/// @brief epoll_event::data.u64 的低 3 位标记注册对象的类型，其余位为对象地址
+enum EventTag : uint64_t {
+	kTagEvent = 0,
+	kTagNotifier = 1,
+	kTagTimer = 2,
+	kTagMask = 7
+};
+
+} // namespace
+
 cc::EpollPoller::EpollPoller(Scheduler* owner)
-	: owner_(owner)
+	: Poller(owner, Backend::kEpoll)
 	, epollFd_(::epoll_create1(O_CLOEXEC))
-	, notifier_(std::make_unique<Notifier>(this))
-	, timerManager_(std::make_unique<TimerManager>(this))
 {
 	if (epollFd_ == -1) {
 		SYLAR_LOG_FMT_FATAL(sys_logger, "failed to invoke ::epoll_create, errno=%d, errstr: %s, about to exit\n"
 				, errno, std::strerror(errno));
 		std::abort();
 	}
+	static_assert(alignof(Event) > kTagMask, "tag bits must not overlap Event pointers");
+	notifier_ = std::make_unique<Notifier>(this);
+	timerManager_ = std::make_unique<TimerManager>(this);
 
-	/// FIXME:
-	///		重构Notifier/TimerManager与Poller的关系
 	struct ::epoll_event notifier_e_e;
 	std::memset(&notifier_e_e, 0, sizeof(::epoll_event));
-	notifier_e_e.data.fd = notifier_->GetEventFd();
+	notifier_e_e.data.u64 = reinterpret_cast<uint64_t>(notifier_.get()) | kTagNotifier;
 	notifier_e_e.events = EPOLLIN;
 	::epoll_ctl(epollFd_, EPOLL_CTL_ADD, notifier_->GetEventFd(), &notifier_e_e);
 
-	struct ::epoll_event timerfd_e_e;
-	std::memset(&timerfd_e_e, 0, sizeof(::epoll_event));
-	timerfd_e_e.data.fd = timerManager_->GetTimerFd();
-	timerfd_e_e.events = EPOLLIN | EPOLLET;
-	::epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerManager_->GetTimerFd(), &timerfd_e_e);
+	WatchTimerManager(timerManager_.get());
 }
 
 cc::EpollPoller::~EpollPoller() noexcept {
 	::epoll_ctl(epollFd_, EPOLL_CTL_DEL, notifier_->GetEventFd(), nullptr);
 	::epoll_ctl(epollFd_, EPOLL_CTL_DEL, timerManager_->GetTimerFd(), nullptr);
 	::close(epollFd_);
+}
 
-	for (const auto& pair : eventSet_) {
-		delete pair.second;
-	}
+void cc::EpollPoller::WatchTimerManager(TimerManager* timer_manager) {
+	struct ::epoll_event timerfd_e_e;
+	std::memset(&timerfd_e_e, 0, sizeof(::epoll_event));
+	timerfd_e_e.data.u64 = reinterpret_cast<uint64_t>(timer_manager) | kTagTimer;
+	timerfd_e_e.events = EPOLLIN | EPOLLET;
+	::epoll_ctl(epollFd_, EPOLL_CTL_ADD, timer_manager->GetTimerFd(), &timerfd_e_e);
 }
 
 void cc::EpollPoller::UpdateEvent(int fd, unsigned interest_events, std::function<void()> func) {
@@ -59,243 +136,235 @@ void cc::EpollPoller::UpdateEvent(int fd, unsigned interest_events, std::functio
 	// get event object
 	Event* event = GetOrCreateEventObj(fd);
 
-	// manipulate event object
-	std::lock_guard<std::mutex> event_guard(event->mutex);
-	// 设置 EPOLLET 为避免多线程惊群现象
-	event->interest_event = EPOLLET | interest_events;
-	int op = event->state == Event::StateIndex::kAdded
-		? EPOLL_CTL_MOD
-		: EPOLL_CTL_ADD;
-	Update(op, event);
-	event->state = Event::StateIndex::kAdded;
-
-	// add callback
-	if (interest_events & EPOLLIN) {
-		if (func) {
-			event->read_context.func = func;
-		} else {
-			event->read_context.co = cc::this_thread::GetCurrentRunningCoroutine();		/// ?????
+	// 只保留本次指定的事件
+	for (unsigned target_event : {EPOLLIN, EPOLLOUT}) {
+		if (!(interest_events & target_event)) {
+			ClaimWaiter(event, target_event, nullptr);
 		}
 	}
 
-	if (interest_events & EPOLLOUT) {
-		if (func) {
-			event->write_context.func = std::move(func);
-		} else {
-			event->write_context.co = cc::this_thread::GetCurrentRunningCoroutine();	/// ?????
-		}
-	}
+	AppendEvent(fd, interest_events, std::move(func));
 }
 
 void cc::EpollPoller::CancelEvent(int fd, unsigned target_events) {
 	// get event object
 	Event* event = GetOrCreateEventObj(fd);
 
-	std::lock_guard<std::mutex> event_guard(event->mutex);
-	bool has_target_events = event->interest_event & target_events;
+	bool has_target_events = false;
+	for (unsigned target_event : {EPOLLIN, EPOLLOUT}) {
+		if (target_events & target_event) {
+			has_target_events |= ClaimWaiter(event, target_event, nullptr);
+		}
+	}
+
 	if (!has_target_events) {
 		SYLAR_LOG_WARN(sylar_logger) << "failed to cancel event, has no events" << target_events << " on fd " << fd;
 		return;
 	}
 
-	CancelEvent(event, target_events);
+	// 撤销的方向不再被上报
+	Arm(event);
 }
 
-void sylar::concurrency::EpollPoller::CancelEvent(Event* event, unsigned target_events) {
-	SYLAR_ASSERT(event->state == Event::StateIndex::kAdded);
+cc::Event* cc::EpollPoller::GetOrCreateEventObj(int fd) {
+	return eventTable_.Get(fd);
+}
 
-	event->interest_event &= ~target_events;
-	int op = event->interest_event & ~EPOLLET
-		? EPOLL_CTL_MOD
-		: EPOLL_CTL_DEL;
-	Update(op, event);
+void cc::EpollPoller::PollAndHandle() {
+#define EPOLL_TIMEOUT 5000
+	AssertInSchedulingScope();
 
-	if (op == EPOLL_CTL_DEL) {
-		event->state = Event::StateIndex::kDeleted;
+	while (Poll(EPOLL_TIMEOUT) == 0) {
+		// timeout or interrupted, and no ready event
 	}
+}
 
-	if (target_events & EPOLLIN) {
-		event->read_context.func = nullptr;
-		event->read_context.co = nullptr;
-	}
+size_t cc::EpollPoller::TryPollAndHandle() {
+	AssertInSchedulingScope();
+	return Poll(0);
+}
+
+size_t cc::EpollPoller::Poll(int timeout_ms) {
+	// a coroutine usually has a tiny stack size, the buffer is allocated on heap
+	EventBuffer& buffer = tl_event_buffer;
 
-	if (target_events & EPOLLOUT) {
-		event->read_context.func = nullptr;
-		event->read_context.co = nullptr;
+	int num = ::epoll_wait(epollFd_, buffer.Data(), static_cast<int>(buffer.Size()), timeout_ms);
+	if (num < 0) {
+		if (errno != EINTR) {
+			SYLAR_LOG_ERROR(sys_logger) << "occur a error when invoke ::epoll_wait"
+					<< ", errno=" << errno << ", errstr: " << std::strerror(errno)
+					<< ", continue polling" << std::endl;
+		}
+		return 0;
+	} else if (num == 0) {
+		// 忙轮询时空手而归是常态，不计入缓冲区的负载
+		if (timeout_ms != 0) {
+			buffer.Adapt(0);
+		}
+		return 0;
 	}
+
+	base::CachedClock::Refresh();
+	const size_t length = static_cast<size_t>(num);
+	RecordBatch(length, length == buffer.Size());
+	HandleReadyEvents(buffer.Data(), length);
+	// 就绪事件已处理完毕，此后才可调整缓冲区
+	buffer.Adapt(length);
+	return length;
 }
 
-cc::Event* cc::EpollPoller::GetOrCreateEventObj(int fd) {
-	{	// try to get
-		std::shared_lock<std::shared_mutex> shared_guard(rwMutex_);
-		bool exist = eventSet_.count(fd);
-		if (exist)
-			return eventSet_[fd];
+void cc::EpollPoller::AppendEvent(int fd, unsigned interest_events, std::function<void()> func) {
+	auto event = GetOrCreateEventObj(fd);
+
+	// add callback
+	if (interest_events & EPOLLIN) {
+		SetWaiter(event, EPOLLIN, (interest_events & EPOLLOUT) ? func : std::move(func));
 	}
 
-	{
-		std::lock_guard<std::shared_mutex> guard(rwMutex_);
-		if (eventSet_[fd] == nullptr) {
-			auto new_event = new Event();
-			new_event->fd = fd;
-			eventSet_[fd] = new_event;
-		}
+	if (interest_events & EPOLLOUT) {
+		SetWaiter(event, EPOLLOUT, std::move(func));
 	}
-	return eventSet_[fd];
-}
 
-void cc::EpollPoller::PollAndHandle() {
-#define EPOLL_TIMEOUT 5000
-#define EPOLL_MAX_EVENT 64
-	AssertInSchedulingScope();
+	Arm(event);
+}
 
-	// a coroutine usually has a tiny stack size, allocate on head
-	std::unique_ptr<epoll_event, void(*)(epoll_event*)> unique_p_e_e
-		(new epoll_event[EPOLL_MAX_EVENT],
-		[](epoll_event* event_array) {
-			delete[] event_array;
-		});
+void cc::EpollPoller::SetWaiter(Event* event, unsigned target_event, std::function<void()> func) {
+	Event::Waiter& waiter = event->GetWaiter(target_event);
 
+	// 独占槽位，已在等待中的等待者被替换；其他线程正在写入或取出时稍后重试
+	Event::Waiter::State state = waiter.state.load(std::memory_order::memory_order_acquire);
 	while (true) {
-		int num = ::epoll_wait(epollFd_, unique_p_e_e.get(),EPOLL_MAX_EVENT, EPOLL_TIMEOUT);
-		if (num < 0) {
-			if (errno == EINTR) { continue; }
-			else {
-				SYLAR_LOG_ERROR(sys_logger) << "occur a error when invoke ::epoll_wait"
-						<< ", errno=" << errno << ", errstr: " << std::strerror(errno)
-						<< ", continue polling" << std::endl;
-			}
-			continue;
-		} else if (num == 0) {
-			// timeout and no ready event
-			continue;
-		} else {
-			HandleReadyEvents(unique_p_e_e.get(), static_cast<size_t>(num));
+		if ((state == Event::Waiter::State::kEmpty || state == Event::Waiter::State::kWaiting)
+				&& waiter.state.compare_exchange_weak(state, Event::Waiter::State::kArming,
+					std::memory_order::memory_order_acquire, std::memory_order::memory_order_acquire))
+		{
 			break;
 		}
+		if (state == Event::Waiter::State::kArming || state == Event::Waiter::State::kClaimed) {
+			::sched_yield();
+			state = waiter.state.load(std::memory_order::memory_order_acquire);
+		}
 	}
 
-}
+	if (func) {
+		waiter.func = std::move(func);
+		waiter.co = nullptr;
+	} else {
+		waiter.func = nullptr;
+		waiter.co = cc::this_thread::GetCurrentRunningCoroutine();
+	}
 
-void cc::EpollPoller::AppendEvent(int fd, unsigned interest_events, std::function<void()> func) {
-	auto event = GetOrCreateEventObj(fd);
-	std::lock_guard<std::mutex> event_guard(event->mutex);
+	// 先置位兴趣事件再进入等待: 否则 poller 取得等待者并清除兴趣事件后，
+	// 此处迟到的置位会留下一个没有等待者的兴趣事件
+	event->interest_event.fetch_or(target_event, std::memory_order::memory_order_acq_rel);
+	waiter.state.store(Event::Waiter::State::kWaiting, std::memory_order::memory_order_release);
+}
 
-	// append events
-	event->interest_event |= (EPOLLET | interest_events);
-	int op = event->state == Event::StateIndex::kAdded
-		? EPOLL_CTL_MOD
-		: EPOLL_CTL_ADD;
-	Update(op, event);
+bool cc::EpollPoller::ClaimWaiter(Event* event, unsigned target_event, Scheduler::TaskBatch* batch) {
+	Event::Waiter& waiter = event->GetWaiter(target_event);
 
-	// add callback
-	if (interest_events & EPOLLIN) {
-		if (func) {
-			event->read_context.func = func;
-		} else {
-			event->read_context.co = cc::this_thread::GetCurrentRunningCoroutine();
-		}
+	Event::Waiter::State expected = Event::Waiter::State::kWaiting;
+	if (!waiter.state.compare_exchange_strong(expected, Event::Waiter::State::kClaimed,
+			std::memory_order::memory_order_acq_rel, std::memory_order::memory_order_relaxed))
+	{
+		// 没有等待者，或已被其他线程取得
+		return false;
 	}
 
-	if (interest_events & EPOLLOUT) {
-		if (func) {
-			event->write_context.func = std::move(func);
+	event->interest_event.fetch_and(~target_event, std::memory_order::memory_order_acq_rel);
+
+	if (batch) {
+		// multi-reactor 模式下只有 fd 所属的线程等待此 poller，任务留在该线程上执行
+		const ::pthread_t home_thread = owner_->IsMultiReactor() ? base::GetPthreadId() : INVALID_PTHREAD_ID;
+		SYLAR_ASSERT(waiter.func || waiter.co);
+		if (waiter.co) {
+			batch->Add(std::move(waiter.co), home_thread);
 		} else {
-			event->read_context.co = cc::this_thread::GetCurrentRunningCoroutine();
+			batch->Add(std::move(waiter.func), home_thread);
 		}
 	}
+	waiter.func = nullptr;
+	waiter.co = nullptr;
+
+	waiter.state.store(Event::Waiter::State::kEmpty, std::memory_order::memory_order_release);
+	return true;
 }
 
 void cc::EpollPoller::HandleReadyEvents(epoll_event* ready_event_array, size_t length) {
+	// 就绪事件对应的任务在处理完所有事件后一次性提交
+	Scheduler::TaskBatch batch;
 	for (size_t i = 0; i < length; ++i) {
 		auto cur_e_e = ready_event_array[i];
 
-		if (cur_e_e.data.fd == notifier_->GetEventFd()) {
+		const uint64_t tag = cur_e_e.data.u64 & kTagMask;
+		if (tag == kTagNotifier) {
 			notifier_->HandleEventFd();
 			continue;
-		} else if (cur_e_e.data.fd == timerManager_->GetTimerFd()) {
-			timerManager_->HandleExpiredTimers();
+		} else if (tag == kTagTimer) {
+			reinterpret_cast<TimerManager*>(cur_e_e.data.u64 & ~uint64_t(kTagMask))->HandleExpiredTimers();
 			continue;
 		}
 
 		Event* current_event = static_cast<Event*>(cur_e_e.data.ptr);
+		SYLAR_ASSERT(eventTable_.Find(current_event->fd) == current_event);
 
-#ifndef NDEBUG
-		{
-			std::shared_lock<std::shared_mutex> read_lock(this->rwMutex_);
-			SYLAR_ASSERT(eventSet_.count(current_event->fd) == 1);
-			SYLAR_ASSERT(eventSet_[current_event->fd] == current_event);
+		unsigned ready_event = cur_e_e.events;
+		if (ready_event & (EPOLLERR | EPOLLHUP)) {
+			// 错误与挂断由两个方向的等待者在重试 IO 时得知
+			ready_event |= EPOLLIN | EPOLLOUT;
 		}
-#endif
 
-		std::lock_guard<std::mutex> guard(current_event->mutex);
-		if ((current_event->interest_event & cur_e_e.events) == 0) {
-			// 当前就绪的事件已被其他线程接收，考虑用EPOLLONESHOT同步
-			continue;
+		if (ready_event & (EPOLLIN | EPOLLRDHUP | EPOLLPRI)) {
+			ClaimWaiter(current_event, EPOLLIN, &batch);
 		}
 
-		// 处理就绪的EPOLL事件
-		HandleEpollEvents(current_event, cur_e_e.events);
-		// 更新兴趣事件，只关注剩余的事件
-		CancelEvent(current_event, cur_e_e.events);
-	}
-}
-
-void cc::EpollPoller::Update(int op, Event* event) {
-	struct ::epoll_event e_e;
-	std::memset(&e_e, 0, sizeof e_e);
-	e_e.data.ptr = event;
-	e_e.events = event->interest_event;
-
-	if (::epoll_ctl(epollFd_, op, event->fd, &e_e) < 0) {
-      SYLAR_LOG_ERROR(sys_logger) << "failed to invoke ::epoll_ctl, op="
-	  		<< op << ", fd=" << event->fd << ", errno=" << errno
-			<< " errstr: " << std::strerror(errno) << std::endl;
-	}
-}
-
-void cc::EpollPoller::HandleEpollEvents(Event* event_instance, unsigned ready_event) {
-	if ((ready_event & EPOLLHUP) && !(ready_event & EPOLLIN)) {
-		SYLAR_LOG_WARN(sys_logger) << "fd " << event_instance->fd
-				<< " is hung up, about to close it" << std::endl;
-		/// TODO: close current fd
-	}
-
-	if (ready_event & EPOLLERR) {
-		/// TODO: use ::getsockopt to get error
-		ready_event |= EPOLLIN | EPOLLOUT;
-	}
+		if (ready_event & EPOLLOUT) {
+			ClaimWaiter(current_event, EPOLLOUT, &batch);
+		}
 
-	if (ready_event & (EPOLLIN | EPOLLRDHUP | EPOLLPRI)) {
-		// 封装读任务协程入队
-		EnqueueAndRemove(event_instance, EventEnum::kRead);
+		// EPOLLONESHOT 使该 fd 暂停上报，若仍有其他方向在等待则重新注册
+		if (current_event->interest_event.load(std::memory_order::memory_order_acquire) != 0) {
+			Arm(current_event);
+		}
 	}
 
-	if (ready_event & EPOLLOUT) {
-		// 封装写任务协程入队
-		EnqueueAndRemove(event_instance, EventEnum::kWrite);
-	}
+	owner_->Co(batch);
 }
 
-void cc::EpollPoller::EnqueueAndRemove(Event* event, EventEnum flag) {
-	switch (flag) {
-	case EventEnum::kRead:
-		SYLAR_ASSERT(event->read_context.func || event->read_context.co);
+void cc::EpollPoller::Arm(Event* event) {
+	uint32_t interest_event = event->interest_event.load(std::memory_order::memory_order_acquire);
+	int op = event->registered.load(std::memory_order::memory_order_acquire)
+		? EPOLL_CTL_MOD
+		: EPOLL_CTL_ADD;
 
-		if (event->read_context.co) {
-			this->owner_->Co(std::move(event->read_context.co));
-		} else {
-			this->owner_->Co(std::move(event->read_context.func));
+	while (true) {
+		struct ::epoll_event e_e;
+		std::memset(&e_e, 0, sizeof e_e);
+		e_e.data.ptr = event;
+		e_e.events = interest_event | EPOLLONESHOT;
+
+		if (::epoll_ctl(epollFd_, op, event->fd, &e_e) < 0) {
+			// 并发的注册者可能已先一步加入；fd 被关闭后会被自动移出 epoll
+			if (op == EPOLL_CTL_ADD && errno == EEXIST) {
+				op = EPOLL_CTL_MOD;
+				continue;
+			} else if (op == EPOLL_CTL_MOD && errno == ENOENT) {
+				op = EPOLL_CTL_ADD;
+				continue;
+			}
+			SYLAR_LOG_ERROR(sys_logger) << "failed to invoke ::epoll_ctl, op="
+					<< op << ", fd=" << event->fd << ", errno=" << errno
+					<< " errstr: " << std::strerror(errno) << std::endl;
+			return;
 		}
-		break;
-	case EventEnum::kWrite:
-		SYLAR_ASSERT(event->write_context.func || event->write_context.co);
+		event->registered.store(true, std::memory_order::memory_order_release);
 
-		if (event->write_context.co) {
-			this->owner_->Co(std::move(event->write_context.co));
-		} else {
-			this->owner_->Co(std::move(event->write_context.func));
+		// 期间兴趣事件被其他线程改变时，本次注册可能覆盖其更新，需再次注册
+		uint32_t latest = event->interest_event.load(std::memory_order::memory_order_acquire);
+		if (latest == interest_event) {
+			return;
 		}
-		break;
+		interest_event = latest;
+		op = EPOLL_CTL_MOD;
 	}
 }
@@ -1,103 +1,96 @@
 #pragma once
+#include <concurrency/poller.h>
 #include <concurrency/scheduler.h>
+#include <concurrency/fd_table.h>
 
+#include <atomic>
 #include <sys/epoll.h>
-#include <unordered_map>
-#include <shared_mutex>
 
 namespace sylar {
 namespace concurrency {
 
-class Notifier;
-class TimerManager;
-
+/// @brief fd 上的事件对象，不加锁，由原子状态在注册者、撤销者与 poller 之间同步
+///
+///		   - fd 以 EPOLLONESHOT 注册，每次就绪只上报一次，处理后按剩余的兴趣事件重新注册
+///		   - 每个方向各有一个等待者槽位，以 CAS 将其由 kWaiting 改为 kClaimed 的一方
+///		     (poller 或撤销者)独占其回调，因此一次就绪至多被处理一次
+///		   - 兴趣事件中的某一位被置位，先于对应槽位进入 kWaiting；被清除，先于槽位回到 kEmpty
 struct Event {
-	enum class StateIndex : uint8_t {
-		kNew,
-		kDeleted,
-		kAdded
-	};
-
-	struct {
+	struct Waiter {
+		enum class State : uint8_t {
+			kEmpty,
+			kArming,	///< 注册者正在写入回调
+			kWaiting,	///< 等待就绪
+			kClaimed	///< 已被 poller 或撤销者取得
+		};
+
+		std::atomic<State> state {State::kEmpty};
 		std::function<void()> func;
 		std::shared_ptr<concurrency::Coroutine> co;
-	} read_context;
+	};
 
-	struct {
-		std::function<void()> func;
-		std::shared_ptr<concurrency::Coroutine> co;
-	} write_context;
-
-	void Reset() {
-		this->fd = -1;
-		this->interest_event = 0;
-		this->state = StateIndex::kNew;
-		this->read_context = {};
-		this->write_context = {};
-	}
-
-	int fd = -1;
-	unsigned interest_event = 0;
-	StateIndex state = StateIndex::kNew;
-	// unsigned ready_event;
-	std::mutex mutex;
+	explicit Event(int a_fd)
+		: fd(a_fd)
+		{}
+
+	Waiter& GetWaiter(unsigned event)
+	{ return event == EPOLLIN ? read_waiter : write_waiter; }
+
+	const int fd;
+	/// @brief 处于等待中的方向，EPOLLIN 和/或 EPOLLOUT
+	std::atomic<uint32_t> interest_event {0};
+	/// @brief 是否曾被加入 epoll，仅用于选择 EPOLL_CTL_ADD 或 EPOLL_CTL_MOD
+	std::atomic<bool> registered {false};
+	Waiter read_waiter;
+	Waiter write_waiter;
 };
 
-class EpollPoller {
+class EpollPoller : public Poller {
 public:
 	EpollPoller(Scheduler* owner);
 
-	~EpollPoller() noexcept;
-
-	/// @brief Poll and handle ready events, wrap events as a coroutine
-	void PollAndHandle();
+	~EpollPoller() noexcept override;
 
-	/// @brief Append events to the specified fd
-	/// @param fd  target fd
-	/// @param interest_events  the registered events
-	/// @param func  the callback associaled the events
-	void AppendEvent(int fd, unsigned interest_events, std::function<void()> func);
+	void PollAndHandle() override;
 
-	void UpdateEvent(int fd, unsigned interest_events, std::function<void()> func);
+	size_t TryPollAndHandle() override;
 
-	void CancelEvent(int fd, unsigned target_events);
+	void AppendEvent(int fd, unsigned interest_events, std::function<void()> func) override;
 
-	Scheduler* GetScheduler() const
-	{ return owner_; }
+	void UpdateEvent(int fd, unsigned interest_events, std::function<void()> func) override;
 
-	Notifier* GetNotifier() const
-	{ return notifier_.get(); }
+	void CancelEvent(int fd, unsigned target_events) override;
 
-	TimerManager* GetTimerManager() const
-	{ return timerManager_.get(); }
+protected:
+	void WatchTimerManager(TimerManager* timer_manager) override;
 
 private:
 	Event* GetOrCreateEventObj(int fd);
-	void CancelEvent(Event* event, unsigned target_events);
 
-private:
-	enum class EventEnum : unsigned {
-		kRead,
-		kWrite
-	};
+	/// @brief 为 @a event 的 @a target_event 方向设置等待者，已有的等待者被替换
+	void SetWaiter(Event* event, unsigned target_event, std::function<void()> func);
+
+	/// @brief 取得 @a event 上 @a target_event 方向的等待者，并清除该方向的兴趣事件
+	/// @param batch  取得的回调加入其中，为空则丢弃
+	/// @return 是否有处于等待中的等待者
+	bool ClaimWaiter(Event* event, unsigned target_event, Scheduler::TaskBatch* batch);
+
+	/// @brief 调用一次 epoll_wait 并处理返回的就绪事件
+	/// @return 处理的事件数，出错时为 0
+	size_t Poll(int timeout_ms);
 
 	void HandleReadyEvents(epoll_event* ready_event_array, size_t length);
-	void HandleEpollEvents(Event* event_instance, unsigned ready_event);
-	void EnqueueAndRemove(Event* event, EventEnum flag);
 
-	/// @brief Update to epoll object
-	void Update(int op, Event* event);
+	/// @brief 按当前的兴趣事件(重新)注册 @a event，直至注册的事件与最新的兴趣事件一致
+	void Arm(Event* event);
+
 	void AssertInSchedulingScope() const
 	{ owner_->AssertInSchedulingScope(); }
 
 
 private:
-	concurrency::Scheduler* const owner_;
 	int epollFd_;
-	std::unordered_map<int, Event*> eventSet_;
-	std::unique_ptr<concurrency::Notifier> notifier_;
-	std::unique_ptr<concurrency::TimerManager> timerManager_;
-	mutable std::shared_mutex rwMutex_;
+	FdTable<Event> eventTable_;
 };
 
 } // namespace concurrency
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <concurrency/chunked_table.h>
+
+#include <cstddef>
+#include <sys/resource.h>
+
+namespace sylar {
+namespace concurrency {
+
+/// @brief 以 fd 为下标的分块数组，见 ChunkedTable
+///
+///		   块目录的长度在构造时按 RLIMIT_NOFILE 的硬限制确定
+/// @tparam T  元素类型，须可由 fd 构造
+template <typename T, size_t ChunkSize = 256>
+class FdTable {
+public:
+	FdTable()
+		: table_(GetFdLimit())
+		{}
+
+	/// @brief 获取 @a fd 对应的元素，其所在的块尚未分配时分配之
+	T* Get(int fd) {
+		SYLAR_ASSERT_WITH_MSG(fd >= 0 && static_cast<size_t>(fd) < Capacity(), "fd is out of the range of FdTable");
+		return table_.Get(static_cast<size_t>(fd));
+	}
+
+	/// @brief 获取 @a fd 对应的元素，其所在的块尚未分配时返回 nullptr
+	T* Find(int fd) const
+	{ return fd < 0 ? nullptr : table_.Find(static_cast<size_t>(fd)); }
+
+	/// @brief 可容纳的 fd 上限(不含)
+	size_t Capacity() const
+	{ return table_.Capacity(); }
+
+private:
+	/// @brief 块目录覆盖的 fd 数量上限，避免硬限制为 RLIM_INFINITY 时目录过大
+	static constexpr size_t kMaxFdNum = size_t(1) << 24;
+
+	static size_t GetFdLimit() {
+		size_t fd_num = kMaxFdNum;
+		struct ::rlimit limit;
+		if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_max != RLIM_INFINITY
+				&& static_cast<size_t>(limit.rlim_max) < fd_num)
+		{
+			fd_num = static_cast<size_t>(limit.rlim_max);
+		}
+		return fd_num;
+	}
+
+private:
+	ChunkedTable<T, ChunkSize> table_;
+};
+
+} // namespace concurrency
+} // namespace sylar
@@ -3,13 +3,18 @@
 #include <concurrency/coroutine.h>
 #include <concurrency/fd_manager.h>
 #include <concurrency/timer_manager.h>
+#ifdef SYLAR_IO_URING
+#include <concurrency/io_uring_poller.h>
+#endif
 #include <base/singleton.hpp>
+#include <base/config.h>
 #include <base/debug.h>
 
 #include <dlfcn.h>
 #include <fcntl.h>
 #include <sys/socket.h>
 #include <cstdarg>
+#include <cstring>
 
 #define HOOKED_FUNCS(op)	\
     op(sleep) 			\
@@ -23,15 +28,14 @@
     op(accept) 			\
     op(read) 			\
     op(write) 			\
-    // op(readv) 			\
-    // op(recv) 			\
-    // op(recvfrom) 		\
-    // op(recvmsg) 		\
-    // op(writev) 			\
-    // op(send) 			\
-    // op(sendto) 			\
-    // op(sendmsg) 		\
-    // op(close) 			\
+    op(readv) 			\
+    op(recv) 			\
+    op(recvfrom) 		\
+    op(recvmsg) 		\
+    op(writev) 			\
+    op(send) 			\
+    op(sendto) 			\
+    op(sendmsg)
 
 using namespace sylar;
 namespace cc = sylar::concurrency;
@@ -85,12 +89,64 @@ HOOKED_FUNCS(DEFINE_ORIGINAL_LIBC_FUNCS)	// do define
 
 namespace {
 
+/// @brief 一次带超时的等待，就绪回调与超时定时器中先取得 resumed 的一方恢复协程
 struct TimeoutFlag {
+	std::atomic<bool> resumed {false};
 	bool is_timeout = false;
 };
 
 } // namespace
 
+static std::atomic<uint32_t> s_busy_poll_socket_us {0};
+
+struct __InitHookConfigHelper {
+	__InitHookConfigHelper() {
+		auto& config = base::Singleton<base::ConfigManager>::GetInstance();
+
+		auto busy_poll_socket_us = config.AddOrUpdate<uint32_t>("scheduler.busy_poll.socket_us",
+				s_busy_poll_socket_us.load(), "SO_BUSY_POLL microseconds set on hooked sockets, 0 leaves the option untouched");
+		busy_poll_socket_us->AddMonitor([](const uint32_t&, const uint32_t& now) {
+			s_busy_poll_socket_us.store(now, std::memory_order::memory_order_relaxed);
+		});
+	}
+};
+
+static __InitHookConfigHelper s_init_hook_config_helper {};
+
+/// @brief 为新创建的 fd 建立上下文，close 未被 hook，因此先移除相同 fd 的残留上下文
+static void RegisterFd(int fd) {
+	auto& fd_manager = base::Singleton<cc::FdManager>::GetInstance();
+	if (fd_manager.IsExist(fd)) {
+		fd_manager.RemoveFd(fd);
+	}
+	auto& fd_cxt = fd_manager.CreateFdContext(fd);
+
+	// 由内核在读取时直接轮询网卡队列，超出 net.core.busy_read 需要 CAP_NET_ADMIN
+	int busy_poll_us = static_cast<int>(s_busy_poll_socket_us.load(std::memory_order::memory_order_relaxed));
+	if (fd_cxt.is_socket && busy_poll_us > 0
+			&& cc::setsockopt_libc_func(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_us, sizeof busy_poll_us) < 0)
+	{
+		SYLAR_LOG_DEBUG(sylar_logger) << "failed to set SO_BUSY_POLL on fd " << fd
+				<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+	}
+}
+
+#ifdef SYLAR_IO_URING
+/// @brief 若 @a fd 上的 IO 可以由 io_uring 以完成通知的方式执行，返回负责它的 poller，否则返回 nullptr
+///
+///		   共享栈协程挂起后其栈空间会被其他协程复用，而内核在 IO 完成前仍会访问栈上的缓冲区，因此不适用
+static cc::IoUringPoller* GetCompletionPoller(int fd) {
+	auto& fd_manager = base::Singleton<cc::FdManager>::GetInstance();
+	if (not fd_manager.IsExist(fd) || not fd_manager.GetFdContext(fd).is_socket
+		|| fd_manager.GetFdContext(fd).user_set_nonblock
+		|| cc::this_thread::GetCurrentRunningCoroutine()->IsSharedStack())
+	{
+		return nullptr;
+	}
+	return cc::this_thread::GetScheduler()->GetCompletionPoller(fd);
+}
+#endif
+
 template <typename OriginalLibcFunc, typename... Args>
 static ssize_t do_io(OriginalLibcFunc libc_func, int fd, unsigned interest_event, Args&&... args) {
 	if (!cc::this_thread::IsHooded()) {
@@ -106,46 +162,58 @@ static ssize_t do_io(OriginalLibcFunc libc_func, int fd, unsigned interest_event
 
 	auto& fd_cxt = fd_manager.GetFdContext(fd);
 
-	std::shared_ptr<TimeoutFlag> tie;	// as guard
-	cc::Timer::TimerId timeout_cond_timer_id = cc::TimerManager::kInvalidTimerId;
-
 	while (true) {
 		ssize_t num;
 		do {
 			num = libc_func(fd, std::forward<Args>(args)...);
 		} while (num == -1 && errno == EINTR);
 
-		if (num == -1 && errno == EAGAIN) {
-			// register interest event to poller And wait it appending
-			auto cur_scheduler = cc::this_thread::GetScheduler();
-
-			// set a timer to wait timeout
-			auto timeout = fd_cxt.GetTimeout(interest_event);
-			if (timeout != cc::FdContext::clock::duration::max()) {
-				std::weak_ptr<void> cond(tie);
-				timeout_cond_timer_id = cur_scheduler->RunAfterIf(timeout, cond, [cond, cur_scheduler]() {
-					auto timeout_flag = cond.lock();
-					if (timeout_flag) {
-						auto flag = (TimeoutFlag*)timeout_flag.get();
-						flag->is_timeout = true;
-					}
-				});
-			}
+		if (num != -1 || errno != EAGAIN) {
+			return num;
+		}
 
+		// register interest event to poller And wait it appending
+		auto cur_scheduler = cc::this_thread::GetScheduler();
+		auto timeout = fd_cxt.GetTimeout(interest_event);
+		if (timeout == cc::FdContext::clock::duration::max()) {
 			cur_scheduler->AppendEvent(fd, interest_event, nullptr);
-
 			cc::Coroutine::YieldCurCoroutineToHold();
-			if (not tie->is_timeout) {
-				// cancel cond timer
-				cur_scheduler->CancelTimer(timeout_cond_timer_id);
-				// do io again
-			} else {
-				SYLAR_ASSERT(not cur_scheduler->HasTimer(timeout_cond_timer_id));
-				errno = ETIMEDOUT;
-				return -1;
+			continue;	// do io again
+		}
+
+		// 撤销事件只会丢弃等待者，因此由就绪回调和超时定时器竞争恢复协程
+		auto cur_coroutine = cc::this_thread::GetCurrentRunningCoroutine();
+		auto tie = std::make_shared<TimeoutFlag>();	// as guard
+		cur_scheduler->AppendEvent(fd, interest_event, [tie, cur_scheduler, cur_coroutine]() {
+			if (not tie->resumed.exchange(true)) {
+				cur_scheduler->Co(cur_coroutine);
 			}
+		});
+
+		// set a timer to wait timeout
+		std::weak_ptr<void> cond(tie);
+		cc::Timer::TimerId timeout_cond_timer_id = cur_scheduler->RunAfterIf(timeout, cond,
+			[cond, cur_scheduler, cur_coroutine, fd, interest_event]() {
+				auto timeout_flag = cond.lock();
+				if (timeout_flag) {
+					auto flag = (TimeoutFlag*)timeout_flag.get();
+					if (not flag->resumed.exchange(true)) {
+						flag->is_timeout = true;
+						cur_scheduler->CancelEvent(fd, interest_event);
+						cur_scheduler->Co(cur_coroutine);
+					}
+				}
+			}, false, true
+		);
+
+		cc::Coroutine::YieldCurCoroutineToHold();
+		if (not tie->is_timeout) {
+			// cancel cond timer
+			cur_scheduler->CancelTimer(timeout_cond_timer_id);
+			// do io again
 		} else {
-			return num;
+			errno = ETIMEDOUT;
+			return -1;
 		}
 	}
 }
@@ -159,7 +227,7 @@ extern "C" unsigned int sleep(unsigned int seconds) {
 	auto cur_coroutine = cc::this_thread::GetCurrentRunningCoroutine();
 	cur_scheduler->RunAfter(std::chrono::seconds(seconds), [cur_scheduler, cur_coroutine]() {
 		cur_scheduler->Co(cur_coroutine);
-	});
+	}, false, true);
 	cc::Coroutine::YieldCurCoroutineToHold();
 	return 0;
 }
@@ -173,7 +241,7 @@ extern "C" int usleep(useconds_t usec) {
 	auto cur_coroutine = cc::this_thread::GetCurrentRunningCoroutine();
 	cur_scheduler->RunAfter(std::chrono::microseconds(usec), [cur_scheduler, cur_coroutine]() {
 		cur_scheduler->Co(cur_coroutine);
-	});
+	}, false, true);
 	cc::Coroutine::YieldCurCoroutineToHold();
 	return 0;
 }
@@ -188,7 +256,7 @@ extern "C" int nanosleep(const struct timespec *req, struct timespec *rem) {
 	cur_scheduler->RunAfter(std::chrono::seconds(req->tv_sec) + std::chrono::nanoseconds(req->tv_nsec),
 		[cur_scheduler, cur_coroutine]() {
 			cur_scheduler->Co(cur_coroutine);
-		}
+		}, false, true
 	);
 	cc::Coroutine::YieldCurCoroutineToHold();
 	return 0;
@@ -199,13 +267,22 @@ extern "C" int socket(int domain, int type, int protocol) {
 	int sock = cc::socket_libc_func(domain, type, protocol);
 	if (cc::this_thread::IsHooded() && sock >= 0) {
 		// set NONBLOCK flag in FdContext::Constructor if is socket
-		base::Singleton<cc::FdManager>::GetInstance().CreateFdContext(sock);
+		RegisterFd(sock);
 	}
 
 	return sock;
 }
 
 extern "C" int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen) {
+#ifdef SYLAR_IO_URING
+	if (cc::this_thread::IsHooded()) {
+		if (auto poller = GetCompletionPoller(sockfd)) {
+			// 与内核一致，连接超时取自发送超时
+			auto timeout = base::Singleton<cc::FdManager>::GetInstance().GetFdContext(sockfd).GetTimeout(EPOLLOUT);
+			return poller->Connect(sockfd, addr, addrlen, timeout);
+		}
+	}
+#endif
 	return cc::connect_libc_func(sockfd, addr, addrlen);
 }
 
@@ -214,7 +291,22 @@ extern "C" int accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen) {
 		return cc::accept_libc_func(sockfd, addr, addrlen);
 	}
 
-	return do_io(cc::accept_libc_func, sockfd, EPOLLIN, addr, addrlen);
+	int fd = -1;
+#ifdef SYLAR_IO_URING
+	if (auto poller = GetCompletionPoller(sockfd)) {
+		auto timeout = base::Singleton<cc::FdManager>::GetInstance().GetFdContext(sockfd).GetTimeout(EPOLLIN);
+		fd = poller->Accept(sockfd, addr, addrlen, timeout);
+		// 较旧的内核对非阻塞 fd 直接返回 EAGAIN 而不等待，此时退回就绪通知
+		if (fd < 0 && errno == EAGAIN) {
+			fd = do_io(cc::accept_libc_func, sockfd, EPOLLIN, addr, addrlen);
+		}
+	} else
+#endif
+	fd = do_io(cc::accept_libc_func, sockfd, EPOLLIN, addr, addrlen);
+	if (fd >= 0) {
+		RegisterFd(fd);
+	}
+	return fd;
 }
 
 extern "C" ssize_t read(int fd, void *buf, size_t count) {
@@ -222,6 +314,15 @@ extern "C" ssize_t read(int fd, void *buf, size_t count) {
 		return cc::read_libc_func(fd, buf, count);
 	}
 
+#ifdef SYLAR_IO_URING
+	if (auto poller = GetCompletionPoller(fd)) {
+		auto timeout = base::Singleton<cc::FdManager>::GetInstance().GetFdContext(fd).GetTimeout(EPOLLIN);
+		ssize_t num = poller->Read(fd, buf, count, timeout);
+		if (num >= 0 || errno != EAGAIN) {
+			return num;
+		}
+	}
+#endif
 	return do_io(cc::read_libc_func, fd, EPOLLIN, buf, count);
 }
 
@@ -230,9 +331,69 @@ extern "C" ssize_t write(int fd, const void *buf, size_t count) {
 		return cc::write_libc_func(fd, buf, count);
 	}
 
+#ifdef SYLAR_IO_URING
+	if (auto poller = GetCompletionPoller(fd)) {
+		auto timeout = base::Singleton<cc::FdManager>::GetInstance().GetFdContext(fd).GetTimeout(EPOLLOUT);
+		ssize_t num = poller->Write(fd, buf, count, timeout);
+		if (num >= 0 || errno != EAGAIN) {
+			return num;
+		}
+	}
+#endif
 	return do_io(cc::write_libc_func, fd, EPOLLOUT, buf, count);
 }
 
+extern "C" ssize_t readv(int fd, const struct iovec *iov, int iovcnt) {
+	return do_io(cc::readv_libc_func, fd, EPOLLIN, iov, iovcnt);
+}
+
+/// @note 指定 MSG_DONTWAIT 的调用者自行处理 EAGAIN，不挂起协程
+extern "C" ssize_t recv(int sockfd, void *buf, size_t len, int flags) {
+	if (flags & MSG_DONTWAIT) {
+		return cc::recv_libc_func(sockfd, buf, len, flags);
+	}
+	return do_io(cc::recv_libc_func, sockfd, EPOLLIN, buf, len, flags);
+}
+
+extern "C" ssize_t recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen) {
+	if (flags & MSG_DONTWAIT) {
+		return cc::recvfrom_libc_func(sockfd, buf, len, flags, src_addr, addrlen);
+	}
+	return do_io(cc::recvfrom_libc_func, sockfd, EPOLLIN, buf, len, flags, src_addr, addrlen);
+}
+
+extern "C" ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags) {
+	if (flags & MSG_DONTWAIT) {
+		return cc::recvmsg_libc_func(sockfd, msg, flags);
+	}
+	return do_io(cc::recvmsg_libc_func, sockfd, EPOLLIN, msg, flags);
+}
+
+extern "C" ssize_t writev(int fd, const struct iovec *iov, int iovcnt) {
+	return do_io(cc::writev_libc_func, fd, EPOLLOUT, iov, iovcnt);
+}
+
+extern "C" ssize_t send(int sockfd, const void *buf, size_t len, int flags) {
+	if (flags & MSG_DONTWAIT) {
+		return cc::send_libc_func(sockfd, buf, len, flags);
+	}
+	return do_io(cc::send_libc_func, sockfd, EPOLLOUT, buf, len, flags);
+}
+
+extern "C" ssize_t sendto(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen) {
+	if (flags & MSG_DONTWAIT) {
+		return cc::sendto_libc_func(sockfd, buf, len, flags, dest_addr, addrlen);
+	}
+	return do_io(cc::sendto_libc_func, sockfd, EPOLLOUT, buf, len, flags, dest_addr, addrlen);
+}
+
+extern "C" ssize_t sendmsg(int sockfd, const struct msghdr *msg, int flags) {
+	if (flags & MSG_DONTWAIT) {
+		return cc::sendmsg_libc_func(sockfd, msg, flags);
+	}
+	return do_io(cc::sendmsg_libc_func, sockfd, EPOLLOUT, msg, flags);
+}
+
 extern "C" int fcntl(int fd, int cmd, ... /* arg */ ) {
 	va_list va;
 	va_start(va, cmd);
@@ -2,6 +2,7 @@
 
 #include <time.h>		// for nanosleep
 #include <unistd.h>		// for usleep
+#include <sys/uio.h>		// for readv, writev
 #include <sys/types.h>
 #include <sys/socket.h>
 
@@ -41,6 +42,30 @@ extern read_libc_func_t read_libc_func;
 using write_libc_func_t = ssize_t (*)(int fd, const void *buf, size_t count);
 extern write_libc_func_t write_libc_func;
 
+using readv_libc_func_t = ssize_t (*)(int fd, const struct iovec *iov, int iovcnt);
+extern readv_libc_func_t readv_libc_func;
+
+using recv_libc_func_t = ssize_t (*)(int sockfd, void *buf, size_t len, int flags);
+extern recv_libc_func_t recv_libc_func;
+
+using recvfrom_libc_func_t = ssize_t (*)(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen);
+extern recvfrom_libc_func_t recvfrom_libc_func;
+
+using recvmsg_libc_func_t = ssize_t (*)(int sockfd, struct msghdr *msg, int flags);
+extern recvmsg_libc_func_t recvmsg_libc_func;
+
+using writev_libc_func_t = ssize_t (*)(int fd, const struct iovec *iov, int iovcnt);
+extern writev_libc_func_t writev_libc_func;
+
+using send_libc_func_t = ssize_t (*)(int sockfd, const void *buf, size_t len, int flags);
+extern send_libc_func_t send_libc_func;
+
+using sendto_libc_func_t = ssize_t (*)(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen);
+extern sendto_libc_func_t sendto_libc_func;
+
+using sendmsg_libc_func_t = ssize_t (*)(int sockfd, const struct msghdr *msg, int flags);
+extern sendmsg_libc_func_t sendmsg_libc_func;
+
 
 
 
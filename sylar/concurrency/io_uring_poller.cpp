@@ -0,0 +1,597 @@
+#include <concurrency/io_uring_poller.h>
+#include <concurrency/notifier.h>
+#include <concurrency/timer_manager.h>
+#include <base/log.h>
+#include <base/clock.h>
+#include <base/debug.h>
+
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <sched.h>
+#include <cstring>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto sys_logger = SYLAR_SYS_LOGGER();
+static auto sylar_logger = SYLAR_ROOT_LOGGER();
+
+namespace {
+
+/// @brief 提交队列的容量，完成队列为其两倍
+static constexpr unsigned kRingEntries = 256;
+
+/// @brief user_data 的低 3 位标识 CQE 的来源，其余位为对应对象的地址
+enum Tag : uint64_t {
+	kTagIgnored = 0,	///< 链接的超时与 POLL_REMOVE
+	kTagNotifier = 1,
+	kTagTimer = 2,		///< 其余位为 TimerManager 的地址
+	kTagPollIn = 3,
+	kTagPollOut = 4,
+	kTagCompletion = 5
+};
+
+static constexpr uint64_t kTagMask = 7;
+
+static int SysIoUringSetup(unsigned entries, struct io_uring_params* params) {
+	return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int SysIoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+	return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+static int SysIoUringRegister(int ring_fd, unsigned opcode, void* arg, unsigned nr_args) {
+	return static_cast<int>(::syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+template <typename T>
+static T* RingPtr(void* base, uint32_t offset) {
+	return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+} // namespace
+
+/// @brief 与内核共享的提交/完成队列
+struct cc::IoUringPoller::Ring {
+	int fd = -1;
+	void* ring_ptr = MAP_FAILED;
+	size_t ring_size = 0;
+	io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+	size_t sqes_size = 0;
+
+	unsigned sq_entries = 0;
+	unsigned sq_mask = 0;
+	unsigned* sq_head = nullptr;	///< 由内核推进
+	unsigned* sq_tail = nullptr;	///< 由持有 sqMutex_ 的提交者推进
+	unsigned* sq_array = nullptr;
+
+	unsigned cq_mask = 0;
+	unsigned* cq_head = nullptr;	///< 由正在等待该 poller 的线程推进
+	unsigned* cq_tail = nullptr;	///< 由内核推进
+	io_uring_cqe* cqes = nullptr;
+};
+
+struct cc::IoUringPoller::PollEntry {
+	struct Context {
+		std::function<void()> func;
+		std::shared_ptr<concurrency::Coroutine> co;
+	};
+
+	explicit PollEntry(int a_fd)
+		: fd(a_fd)
+		{}
+
+	int fd = -1;
+	unsigned interest_event = 0;
+	/// @brief 已提交且尚未完成的 POLL_ADD
+	unsigned armed_event = 0;
+	Context read_context;
+	Context write_context;
+	std::mutex mutex;
+};
+
+/// @brief 一次完成通知 IO 的等待者，位于被挂起协程的栈上
+struct cc::IoUringPoller::Completion {
+	std::shared_ptr<concurrency::Coroutine> co;
+	::pthread_t home_thread = INVALID_PTHREAD_ID;
+	int32_t res = 0;
+	struct __kernel_timespec timeout;
+};
+
+bool cc::IoUringPoller::IsSupported() {
+	static const bool s_supported = []() {
+		struct io_uring_params params;
+		std::memset(&params, 0, sizeof params);
+		int ring_fd = SysIoUringSetup(1, &params);
+		if (ring_fd < 0) {
+			return false;
+		}
+
+		bool supported = (params.features & IORING_FEAT_SINGLE_MMAP)
+				&& (params.features & IORING_FEAT_NODROP);
+
+		constexpr unsigned kProbeOpNum = 256;
+		std::unique_ptr<char[]> buffer(new char[sizeof(io_uring_probe) + kProbeOpNum * sizeof(io_uring_probe_op)]());
+		auto probe = reinterpret_cast<io_uring_probe*>(buffer.get());
+		if (supported && SysIoUringRegister(ring_fd, IORING_REGISTER_PROBE, probe, kProbeOpNum) == 0) {
+			for (unsigned op : {IORING_OP_POLL_ADD, IORING_OP_POLL_REMOVE, IORING_OP_READ, IORING_OP_WRITE,
+					IORING_OP_ACCEPT, IORING_OP_CONNECT, IORING_OP_LINK_TIMEOUT})
+			{
+				if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+					supported = false;
+				}
+			}
+		} else {
+			supported = false;
+		}
+
+		::close(ring_fd);
+		return supported;
+	}();
+	return s_supported;
+}
+
+cc::IoUringPoller::IoUringPoller(Scheduler* owner)
+	: Poller(owner, Backend::kIoUring)
+	, ring_(std::make_unique<Ring>())
+	, entryTable_(std::make_unique<FdTable<PollEntry>>())
+{
+	static_assert(alignof(PollEntry) > kTagMask, "the address of PollEntry is tagged in user_data");
+	static_assert(alignof(Completion) > kTagMask, "the address of Completion is tagged in user_data");
+
+	struct io_uring_params params;
+	std::memset(&params, 0, sizeof params);
+	ring_->fd = SysIoUringSetup(kRingEntries, &params);
+	if (ring_->fd < 0) {
+		SYLAR_LOG_FMT_FATAL(sys_logger, "failed to invoke ::io_uring_setup, errno=%d, errstr: %s, about to exit\n"
+				, errno, std::strerror(errno));
+		std::abort();
+	}
+	SYLAR_ASSERT(params.features & IORING_FEAT_SINGLE_MMAP);
+
+	// 提交队列与完成队列共用一次映射
+	ring_->ring_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+			params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+	ring_->ring_ptr = ::mmap(nullptr, ring_->ring_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring_->fd, IORING_OFF_SQ_RING);
+	ring_->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	ring_->sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, ring_->sqes_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring_->fd, IORING_OFF_SQES));
+	if (ring_->ring_ptr == MAP_FAILED || ring_->sqes == MAP_FAILED) {
+		SYLAR_LOG_FMT_FATAL(sys_logger, "failed to mmap io_uring queues, errno=%d, errstr: %s, about to exit\n"
+				, errno, std::strerror(errno));
+		std::abort();
+	}
+
+	ring_->sq_entries = params.sq_entries;
+	ring_->sq_mask = *RingPtr<unsigned>(ring_->ring_ptr, params.sq_off.ring_mask);
+	ring_->sq_head = RingPtr<unsigned>(ring_->ring_ptr, params.sq_off.head);
+	ring_->sq_tail = RingPtr<unsigned>(ring_->ring_ptr, params.sq_off.tail);
+	ring_->sq_array = RingPtr<unsigned>(ring_->ring_ptr, params.sq_off.array);
+	ring_->cq_mask = *RingPtr<unsigned>(ring_->ring_ptr, params.cq_off.ring_mask);
+	ring_->cq_head = RingPtr<unsigned>(ring_->ring_ptr, params.cq_off.head);
+	ring_->cq_tail = RingPtr<unsigned>(ring_->ring_ptr, params.cq_off.tail);
+	ring_->cqes = RingPtr<io_uring_cqe>(ring_->ring_ptr, params.cq_off.cqes);
+
+	notifier_ = std::make_unique<Notifier>(this);
+	timerManager_ = std::make_unique<TimerManager>(this);
+	ArmInternalPoll(notifier_->GetEventFd(), kTagNotifier);
+	WatchTimerManager(timerManager_.get());
+}
+
+cc::IoUringPoller::~IoUringPoller() noexcept {
+	::munmap(ring_->sqes, ring_->sqes_size);
+	::munmap(ring_->ring_ptr, ring_->ring_size);
+	::close(ring_->fd);
+}
+
+void cc::IoUringPoller::PollAndHandle() {
+	AssertInSchedulingScope();
+
+	while (true) {
+		// 完成队列中已有 CQE 时不阻塞
+		const bool has_cqe = __atomic_load_n(ring_->cq_tail, __ATOMIC_ACQUIRE) != *ring_->cq_head;
+		if (Enter(has_cqe ? 0 : 1) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			SYLAR_LOG_ERROR(sys_logger) << "occur a error when invoke ::io_uring_enter"
+					<< ", errno=" << errno << ", errstr: " << std::strerror(errno)
+					<< ", continue polling" << std::endl;
+		}
+
+		if (HandleCompletions() > 0) {
+			break;
+		}
+	}
+}
+
+size_t cc::IoUringPoller::TryPollAndHandle() {
+	AssertInSchedulingScope();
+
+	// 忙轮询时不阻塞于内核，已发布的 SQE 由此提交
+	if (__atomic_load_n(ring_->sq_tail, __ATOMIC_ACQUIRE) != __atomic_load_n(ring_->sq_head, __ATOMIC_ACQUIRE)
+			&& Enter(0) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+	{
+		SYLAR_LOG_ERROR(sys_logger) << "occur a error when invoke ::io_uring_enter"
+				<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+	}
+
+	if (__atomic_load_n(ring_->cq_tail, __ATOMIC_ACQUIRE) == *ring_->cq_head) {
+		return 0;
+	}
+	return HandleCompletions();
+}
+
+void cc::IoUringPoller::AppendEvent(int fd, unsigned interest_events, std::function<void()> func) {
+	PollEntry* entry = GetOrCreateEntry(fd);
+	std::lock_guard<std::mutex> guard(entry->mutex);
+
+	entry->interest_event |= interest_events & (EPOLLIN | EPOLLOUT);
+
+	// add callback
+	if (interest_events & EPOLLIN) {
+		if (func) {
+			entry->read_context.func = func;
+		} else {
+			entry->read_context.co = cc::this_thread::GetCurrentRunningCoroutine();
+		}
+	}
+
+	if (interest_events & EPOLLOUT) {
+		if (func) {
+			entry->write_context.func = std::move(func);
+		} else {
+			entry->write_context.co = cc::this_thread::GetCurrentRunningCoroutine();
+		}
+	}
+
+	ArmPoll(entry);
+}
+
+void cc::IoUringPoller::UpdateEvent(int fd, unsigned interest_events, std::function<void()> func) {
+	SYLAR_ASSERT(interest_events != 0);
+
+	{
+		PollEntry* entry = GetOrCreateEntry(fd);
+		std::lock_guard<std::mutex> guard(entry->mutex);
+		const unsigned removed_events = entry->interest_event & ~interest_events;
+		if (removed_events) {
+			CancelPoll(entry, removed_events);
+		}
+	}
+
+	AppendEvent(fd, interest_events, std::move(func));
+}
+
+void cc::IoUringPoller::CancelEvent(int fd, unsigned target_events) {
+	PollEntry* entry = GetOrCreateEntry(fd);
+
+	std::lock_guard<std::mutex> guard(entry->mutex);
+	if (!(entry->interest_event & target_events)) {
+		SYLAR_LOG_WARN(sylar_logger) << "failed to cancel event, has no events" << target_events << " on fd " << fd;
+		return;
+	}
+
+	CancelPoll(entry, target_events);
+}
+
+ssize_t cc::IoUringPoller::Read(int fd, void* buf, size_t count, Interval timeout) {
+	int32_t res = Await([fd, buf, count](io_uring_sqe* sqe) {
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = fd;
+		sqe->addr = reinterpret_cast<uint64_t>(buf);
+		sqe->len = static_cast<uint32_t>(count);
+		sqe->off = static_cast<uint64_t>(-1);	// 使用并推进文件的当前偏移
+	}, timeout);
+
+	if (res < 0) {
+		errno = -res;
+		return -1;
+	}
+	return res;
+}
+
+ssize_t cc::IoUringPoller::Write(int fd, const void* buf, size_t count, Interval timeout) {
+	int32_t res = Await([fd, buf, count](io_uring_sqe* sqe) {
+		sqe->opcode = IORING_OP_WRITE;
+		sqe->fd = fd;
+		sqe->addr = reinterpret_cast<uint64_t>(buf);
+		sqe->len = static_cast<uint32_t>(count);
+		sqe->off = static_cast<uint64_t>(-1);
+	}, timeout);
+
+	if (res < 0) {
+		errno = -res;
+		return -1;
+	}
+	return res;
+}
+
+int cc::IoUringPoller::Accept(int fd, struct sockaddr* addr, socklen_t* addrlen, Interval timeout) {
+	int32_t res = Await([fd, addr, addrlen](io_uring_sqe* sqe) {
+		sqe->opcode = IORING_OP_ACCEPT;
+		sqe->fd = fd;
+		sqe->addr = reinterpret_cast<uint64_t>(addr);
+		sqe->addr2 = reinterpret_cast<uint64_t>(addrlen);
+	}, timeout);
+
+	if (res < 0) {
+		errno = -res;
+		return -1;
+	}
+	return res;
+}
+
+int cc::IoUringPoller::Connect(int fd, const struct sockaddr* addr, socklen_t addrlen, Interval timeout) {
+	int32_t res = Await([fd, addr, addrlen](io_uring_sqe* sqe) {
+		sqe->opcode = IORING_OP_CONNECT;
+		sqe->fd = fd;
+		sqe->addr = reinterpret_cast<uint64_t>(addr);
+		sqe->off = addrlen;
+	}, timeout);
+
+	if (res < 0) {
+		errno = -res;
+		return -1;
+	}
+	return res;
+}
+
+cc::IoUringPoller::PollEntry* cc::IoUringPoller::GetOrCreateEntry(int fd) {
+	return entryTable_->Get(fd);
+}
+
+void cc::IoUringPoller::ArmPoll(PollEntry* entry) {
+	// 仍在等待中的 POLL_ADD 无需重复提交，被撤销后会在其 CQE 中按最新的兴趣事件重新提交
+	const unsigned pending_events = entry->interest_event & ~entry->armed_event;
+	if (!pending_events) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(sqMutex_);
+	const unsigned num = __builtin_popcount(pending_events);
+	io_uring_sqe* sqes[2];
+	ReserveSqes(num, sqes);
+
+	unsigned i = 0;
+	for (unsigned event : {EPOLLIN, EPOLLOUT}) {
+		if (pending_events & event) {
+			io_uring_sqe* sqe = sqes[i++];
+			sqe->opcode = IORING_OP_POLL_ADD;
+			sqe->fd = entry->fd;
+			sqe->poll32_events = event;		// EPOLLIN/EPOLLOUT 与 POLLIN/POLLOUT 取值相同
+			sqe->user_data = reinterpret_cast<uint64_t>(entry) | (event == EPOLLIN ? kTagPollIn : kTagPollOut);
+		}
+	}
+	entry->armed_event |= pending_events;
+	PublishSqes(num);
+}
+
+void cc::IoUringPoller::CancelPoll(PollEntry* entry, unsigned target_events) {
+	entry->interest_event &= ~target_events;
+
+	if (target_events & EPOLLIN) {
+		entry->read_context = {};
+	}
+
+	if (target_events & EPOLLOUT) {
+		entry->write_context = {};
+	}
+
+	const unsigned removed_events = entry->armed_event & target_events & (EPOLLIN | EPOLLOUT);
+	if (!removed_events) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(sqMutex_);
+	const unsigned num = __builtin_popcount(removed_events);
+	io_uring_sqe* sqes[2];
+	ReserveSqes(num, sqes);
+
+	unsigned i = 0;
+	for (unsigned event : {EPOLLIN, EPOLLOUT}) {
+		if (removed_events & event) {
+			io_uring_sqe* sqe = sqes[i++];
+			sqe->opcode = IORING_OP_POLL_REMOVE;
+			sqe->fd = -1;
+			sqe->addr = reinterpret_cast<uint64_t>(entry) | (event == EPOLLIN ? kTagPollIn : kTagPollOut);
+			sqe->user_data = kTagIgnored;
+		}
+	}
+	PublishSqes(num);
+}
+
+void cc::IoUringPoller::WatchTimerManager(TimerManager* timer_manager) {
+	static_assert(alignof(TimerManager) > kTagMask, "the address of TimerManager is tagged in user_data");
+	ArmInternalPoll(timer_manager->GetTimerFd(), reinterpret_cast<uint64_t>(timer_manager) | kTagTimer);
+}
+
+void cc::IoUringPoller::ArmInternalPoll(int fd, uint64_t user_data) {
+	std::lock_guard<std::mutex> guard(sqMutex_);
+	io_uring_sqe* sqe = nullptr;
+	ReserveSqes(1, &sqe);
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll32_events = EPOLLIN;
+	sqe->user_data = user_data;
+	PublishSqes(1);
+}
+
+template <typename Prepare>
+int32_t cc::IoUringPoller::Await(Prepare&& prepare, Interval timeout) {
+	Completion completion;
+	completion.co = cc::this_thread::GetCurrentRunningCoroutine();
+	// 固定于当前线程恢复，避免协程在挂起前被其他线程换入
+	completion.home_thread = base::GetPthreadId();
+
+	const bool has_timeout = timeout != Interval::max();
+	{
+		std::lock_guard<std::mutex> guard(sqMutex_);
+		io_uring_sqe* sqes[2];
+		ReserveSqes(has_timeout ? 2 : 1, sqes);
+
+		prepare(sqes[0]);
+		sqes[0]->user_data = reinterpret_cast<uint64_t>(&completion) | kTagCompletion;
+
+		if (has_timeout) {
+			auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+			completion.timeout.tv_sec = ns / 1000000000;
+			completion.timeout.tv_nsec = ns % 1000000000;
+
+			sqes[0]->flags |= IOSQE_IO_LINK;
+			sqes[1]->opcode = IORING_OP_LINK_TIMEOUT;
+			sqes[1]->fd = -1;
+			sqes[1]->addr = reinterpret_cast<uint64_t>(&completion.timeout);
+			sqes[1]->len = 1;
+			sqes[1]->user_data = kTagIgnored;
+		}
+		PublishSqes(has_timeout ? 2 : 1);
+	}
+
+	cc::Coroutine::YieldCurCoroutineToHold();
+
+	// 被链接的超时撤销
+	if (has_timeout && completion.res == -ECANCELED) {
+		return -ETIMEDOUT;
+	}
+	return completion.res;
+}
+
+void cc::IoUringPoller::ReserveSqes(unsigned num, io_uring_sqe* sqes[]) {
+	SYLAR_ASSERT(num <= ring_->sq_entries);
+
+	while (true) {
+		const unsigned head = __atomic_load_n(ring_->sq_head, __ATOMIC_ACQUIRE);
+		const unsigned tail = *ring_->sq_tail;
+		if (ring_->sq_entries - (tail - head) >= num) {
+			for (unsigned i = 0; i < num; ++i) {
+				const unsigned index = (tail + i) & ring_->sq_mask;
+				ring_->sq_array[index] = index;
+				sqes[i] = &ring_->sqes[index];
+				std::memset(sqes[i], 0, sizeof(io_uring_sqe));
+			}
+			return;
+		}
+
+		// 提交队列已满，同步提交以腾出空间
+		int ret = SysIoUringEnter(ring_->fd, tail - head, 0, 0);
+		if (ret <= 0) {
+			if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+				SYLAR_LOG_ERROR(sys_logger) << "failed to flush io_uring submission queue"
+						<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+			}
+			::sched_yield();
+		}
+	}
+}
+
+void cc::IoUringPoller::PublishSqes(unsigned num) {
+	__atomic_store_n(ring_->sq_tail, *ring_->sq_tail + num, __ATOMIC_RELEASE);
+
+	if (waiting_.load(std::memory_order::memory_order_acquire)) {
+		// 等待者不会再次进入内核，由提交者代为提交
+		const unsigned to_submit = *ring_->sq_tail - __atomic_load_n(ring_->sq_head, __ATOMIC_ACQUIRE);
+		if (SysIoUringEnter(ring_->fd, to_submit, 0, 0) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			SYLAR_LOG_ERROR(sys_logger) << "failed to submit to io_uring"
+					<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+		}
+	}
+}
+
+int cc::IoUringPoller::Enter(unsigned min_complete) {
+	unsigned to_submit = 0;
+	{
+		// 与 PublishSqes 互斥: 此后发布的 SQE 由其提交者提交
+		std::lock_guard<std::mutex> guard(sqMutex_);
+		to_submit = *ring_->sq_tail - __atomic_load_n(ring_->sq_head, __ATOMIC_ACQUIRE);
+		if (min_complete > 0) {
+			waiting_.store(true, std::memory_order::memory_order_release);
+		}
+	}
+
+	int ret = SysIoUringEnter(ring_->fd, to_submit, min_complete, min_complete > 0 ? IORING_ENTER_GETEVENTS : 0);
+	int saved_errno = errno;
+	waiting_.store(false, std::memory_order::memory_order_release);
+	errno = saved_errno;
+	return ret;
+}
+
+size_t cc::IoUringPoller::HandleCompletions() {
+	// 就绪事件对应的任务在处理完所有 CQE 后一次性提交
+	Scheduler::TaskBatch batch;
+	unsigned head = *ring_->cq_head;
+	const unsigned tail = __atomic_load_n(ring_->cq_tail, __ATOMIC_ACQUIRE);
+	const size_t num = tail - head;
+	if (num != 0) {
+		base::CachedClock::Refresh();
+	}
+
+	for (; head != tail; ++head) {
+		HandleCompletion(ring_->cqes[head & ring_->cq_mask], &batch);
+	}
+	__atomic_store_n(ring_->cq_head, head, __ATOMIC_RELEASE);
+	RecordBatch(num, num > ring_->cq_mask);
+
+	owner_->Co(batch);
+	return num;
+}
+
+void cc::IoUringPoller::HandleCompletion(const io_uring_cqe& cqe, Scheduler::TaskBatch* batch) {
+	const uint64_t tag = cqe.user_data & kTagMask;
+	switch (tag) {
+	case kTagIgnored:
+		break;
+	case kTagNotifier:
+		notifier_->HandleEventFd();
+		ArmInternalPoll(notifier_->GetEventFd(), kTagNotifier);
+		break;
+	case kTagTimer:
+	{
+		TimerManager* timer_manager = reinterpret_cast<TimerManager*>(cqe.user_data & ~kTagMask);
+		timer_manager->HandleExpiredTimers();
+		ArmInternalPoll(timer_manager->GetTimerFd(), cqe.user_data);
+		break;
+	}
+	case kTagPollIn:
+	case kTagPollOut:
+	{
+		PollEntry* entry = reinterpret_cast<PollEntry*>(cqe.user_data & ~kTagMask);
+		const unsigned event = tag == kTagPollIn ? EPOLLIN : EPOLLOUT;
+
+		std::lock_guard<std::mutex> guard(entry->mutex);
+		entry->armed_event &= ~event;
+		if (cqe.res == -ECANCELED) {
+			// 撤销期间可能又注册了兴趣事件
+			ArmPoll(entry);
+			break;
+		}
+
+		if (entry->interest_event & event) {
+			// 与 EpollPoller 相同，multi-reactor 模式下任务留在 fd 所属的线程上执行
+			const ::pthread_t home_thread = owner_->IsMultiReactor() ? base::GetPthreadId() : INVALID_PTHREAD_ID;
+			PollEntry::Context& context = event == EPOLLIN ? entry->read_context : entry->write_context;
+			SYLAR_ASSERT(context.func || context.co);
+			if (context.co) {
+				batch->Add(std::move(context.co), home_thread);
+			} else {
+				batch->Add(std::move(context.func), home_thread);
+			}
+			context = {};
+			entry->interest_event &= ~event;
+		}
+		break;
+	}
+	case kTagCompletion:
+	{
+		Completion* completion = reinterpret_cast<Completion*>(cqe.user_data & ~kTagMask);
+		completion->res = cqe.res;
+		// completion 位于被挂起协程的栈上，提交后不可再访问
+		batch->Add(std::move(completion->co), completion->home_thread);
+		break;
+	}
+	default:
+		SYLAR_ASSERT_WITH_MSG(false, "unknown io_uring completion tag");
+	}
+}
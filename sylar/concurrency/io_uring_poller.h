@@ -0,0 +1,110 @@
+#pragma once
+#include <concurrency/poller.h>
+#include <concurrency/scheduler.h>
+#include <concurrency/fd_table.h>
+
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <sys/socket.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace sylar {
+namespace concurrency {
+
+/// @brief 基于 io_uring 的 poller，仅使用 io_uring_setup/io_uring_enter 系统调用，不依赖 liburing
+///
+///		   - 就绪通知: 兴趣事件以一次性的 IORING_OP_POLL_ADD 提交，
+///		     触发后即移除，与 EpollPoller 的语义相同
+///		   - 完成通知: Read/Write/Accept/Connect 直接以对应的 SQE 提交，
+///		     协程挂起一次即完成一次 IO，结果随 CQE 返回，就绪后无需再次调用系统调用
+///		   - SQE 先写入提交队列，由下一次 io_uring_enter 批量提交；
+///		     若已有线程阻塞于该 poller，则由提交者立即提交
+class IoUringPoller : public Poller {
+public:
+	using Interval = std::chrono::steady_clock::duration;
+
+	/// @brief 当前内核是否支持 io_uring 及所需的全部操作
+	static bool IsSupported();
+
+	explicit IoUringPoller(Scheduler* owner);
+
+	~IoUringPoller() noexcept override;
+
+	void PollAndHandle() override;
+
+	size_t TryPollAndHandle() override;
+
+	void AppendEvent(int fd, unsigned interest_events, std::function<void()> func) override;
+
+	void UpdateEvent(int fd, unsigned interest_events, std::function<void()> func) override;
+
+	void CancelEvent(int fd, unsigned target_events) override;
+
+	/// @brief 以下操作挂起当前协程直至 IO 完成，返回值与 errno 同对应的系统调用
+	///
+	///		   协程被固定于提交时所在的线程上恢复
+	/// @param timeout  超时则返回 -1 且 errno 为 ETIMEDOUT，Interval::max() 表示不超时
+	ssize_t Read(int fd, void* buf, size_t count, Interval timeout);
+
+	ssize_t Write(int fd, const void* buf, size_t count, Interval timeout);
+
+	int Accept(int fd, struct sockaddr* addr, socklen_t* addrlen, Interval timeout);
+
+	int Connect(int fd, const struct sockaddr* addr, socklen_t addrlen, Interval timeout);
+
+protected:
+	void WatchTimerManager(TimerManager* timer_manager) override;
+
+private:
+	struct Ring;
+	struct PollEntry;
+	struct Completion;
+
+	PollEntry* GetOrCreateEntry(int fd);
+
+	/// @brief 为 @a entry 提交尚未提交的兴趣事件，需持有 entry->mutex
+	void ArmPoll(PollEntry* entry);
+
+	/// @brief 撤销 @a entry 上的 @a target_events，需持有 entry->mutex
+	void CancelPoll(PollEntry* entry, unsigned target_events);
+
+	/// @brief 监听 notifier 与 timerfd 的可读事件
+	void ArmInternalPoll(int fd, uint64_t user_data);
+
+	/// @brief 提交由 @a prepare 填充的 SQE 并挂起当前协程，直至其完成
+	/// @return CQE 的结果，超时时为 -ETIMEDOUT
+	template <typename Prepare>
+	int32_t Await(Prepare&& prepare, Interval timeout);
+
+	/// @brief 获取 @a num 个空闲且已清零的 SQE，提交队列已满时先同步提交，需持有 sqMutex_
+	void ReserveSqes(unsigned num, io_uring_sqe* sqes[]);
+
+	/// @brief 发布已填充的 @a num 个 SQE，若有线程阻塞于该 poller，立即提交，需持有 sqMutex_
+	void PublishSqes(unsigned num);
+
+	/// @brief 提交所有已发布的 SQE 并等待至少 @a min_complete 个 CQE
+	int Enter(unsigned min_complete);
+
+	/// @brief 处理所有已完成的 CQE
+	/// @return 处理的 CQE 数量
+	size_t HandleCompletions();
+
+	void HandleCompletion(const io_uring_cqe& cqe, Scheduler::TaskBatch* batch);
+
+	void AssertInSchedulingScope() const
+	{ owner_->AssertInSchedulingScope(); }
+
+private:
+	std::unique_ptr<Ring> ring_;
+	std::unique_ptr<FdTable<PollEntry>> entryTable_;
+	/// @brief 提交队列可被多个线程写入
+	std::mutex sqMutex_;
+	/// @brief 是否有线程阻塞于 io_uring_enter
+	std::atomic<bool> waiting_ {false};
+};
+
+} // namespace concurrency
+} // namespace sylar
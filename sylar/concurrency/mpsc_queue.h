@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace sylar {
+namespace concurrency {
+
+/// @brief MpscQueue 的侵入式节点，元素类型需公有继承此类
+///
+///		   拷贝/赋值时不传递链接状态，使元素类型仍可被拷贝或移动
+struct MpscQueueHook {
+	MpscQueueHook() = default;
+
+	MpscQueueHook(const MpscQueueHook&)
+		{}
+
+	MpscQueueHook& operator=(const MpscQueueHook&)
+	{ return *this; }
+
+	std::atomic<MpscQueueHook*> mpsc_next {nullptr};
+};
+
+/// @brief 无锁侵入式多生产者单消费者队列
+///
+///		   - 任意线程可以调用 Push，仅需一次原子交换
+///		   - 仅消费者线程可以调用 Pop
+///		   - 生产者在交换与链接之间被抢占时，其后入队的元素暂时不可见，
+///		     此时 Pop 返回 nullptr 而 Size 仍计入这些元素
+///
+///		   参考: Dmitry Vyukov. Intrusive MPSC node-based queue
+/// @tparam T  元素类型，须继承自 MpscQueueHook
+template <typename T>
+class MpscQueue {
+public:
+	MpscQueue()
+		: head_(&stub_)
+		, tail_(&stub_)
+		{}
+
+	~MpscQueue() noexcept = default;
+
+	/// @brief 入队，任意线程可调用
+	void Push(T* item) {
+		PushHook(item);
+		size_.fetch_add(1, std::memory_order::memory_order_release);
+	}
+
+	/// @brief 出队，仅消费者线程可调用
+	/// @return 队列为空或生产者尚未完成链接时返回 nullptr
+	T* Pop();
+
+	/// @brief 已完成入队且尚未出队的元素数量
+	size_t Size() const {
+		// 出队可能先于对应的计数，此时计数短暂为负
+		int64_t size = size_.load(std::memory_order::memory_order_acquire);
+		return size > 0 ? static_cast<size_t>(size) : 0;
+	}
+
+	bool Empty() const
+	{ return Size() == 0; }
+
+private:
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	void PushHook(MpscQueueHook* hook) {
+		hook->mpsc_next.store(nullptr, std::memory_order::memory_order_relaxed);
+		MpscQueueHook* prev = head_.exchange(hook, std::memory_order::memory_order_acq_rel);
+		prev->mpsc_next.store(hook, std::memory_order::memory_order_release);
+	}
+
+	T* Take(MpscQueueHook* hook) {
+		size_.fetch_sub(1, std::memory_order::memory_order_relaxed);
+		return static_cast<T*>(hook);
+	}
+
+private:
+	alignas(64) std::atomic<MpscQueueHook*> head_;
+	alignas(64) MpscQueueHook* tail_;
+	std::atomic<int64_t> size_ {0};
+	MpscQueueHook stub_;
+};
+
+template <typename T>
+T* MpscQueue<T>::Pop() {
+	MpscQueueHook* tail = tail_;
+	MpscQueueHook* next = tail->mpsc_next.load(std::memory_order::memory_order_acquire);
+
+	if (tail == &stub_) {
+		if (next == nullptr) {
+			return nullptr;
+		}
+		tail_ = next;
+		tail = next;
+		next = next->mpsc_next.load(std::memory_order::memory_order_acquire);
+	}
+
+	if (next) {
+		tail_ = next;
+		return Take(tail);
+	}
+
+	if (tail != head_.load(std::memory_order::memory_order_acquire)) {
+		// 某个生产者尚未完成链接
+		return nullptr;
+	}
+
+	// tail 是最后一个元素，重新放入 stub 以便将其取出
+	PushHook(&stub_);
+	next = tail->mpsc_next.load(std::memory_order::memory_order_acquire);
+	if (next) {
+		tail_ = next;
+		return Take(tail);
+	}
+	return nullptr;
+}
+
+} // namespace concurrency
+} // namespace sylar
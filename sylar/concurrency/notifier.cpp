@@ -3,6 +3,7 @@
 #include <base/log.h>
 
 #include <cstring>
+#include <cstdint>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/epoll.h>
@@ -12,9 +13,9 @@ namespace cc = sylar::concurrency;
 
 static auto sys_logger = SYLAR_SYS_LOGGER();
 
-cc::Notifier::Notifier(EpollPoller* owner)
+cc::Notifier::Notifier(Poller* owner)
 	: owner_(owner)
-	, eventFd_(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE))
+	, eventFd_(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
 {
 	if (eventFd_ < 0) {
 		SYLAR_LOG_FATAL(sys_logger) << "failed to create eventfd object, about to exit" << std::endl;
@@ -27,20 +28,30 @@ cc::Notifier::~Notifier() {
 	::close(eventFd_);
 }
 
-void cc::Notifier::Notify(uint64_t num) {
+void cc::Notifier::Notify() {
+	if (notified_.exchange(true, std::memory_order::memory_order_acq_rel)) {
+		// 尚未被处理，合并至上一次写入
+		return;
+	}
+
+	uint64_t num = 1;
 	int ret = ::write(eventFd_, &num, sizeof num);
 	if (__builtin_expect(ret < 0, 0)) {
 		SYLAR_LOG_ERROR(sys_logger) << "failed to invoke ::write on eventfd object"
-			<< ", num=" << num <<", errno=" << errno
+			<< ", errno=" << errno
 			<< ", errstr:" << std::strerror(errno) << std::endl;
 	}
 }
 
 void cc::Notifier::HandleEventFd() {
-	char temp_buffer[64] {};
-	int ret = ::read(eventFd_, temp_buffer, 64);
-	if (__builtin_expect(ret < 0, 0)) {
+	uint64_t num = 0;
+	int ret = ::read(eventFd_, &num, sizeof num);
+	if (__builtin_expect(ret < 0 && errno != EAGAIN, 0)) {
 		SYLAR_LOG_WARN(sys_logger) << "failed to invoke ::read on eventfd object"
 			<<", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
 	}
+
+	// 读取后再清除标记: 二者之间被合并的 Notify 无需再次写入，
+	// 因为当前线程返回后会在再次阻塞前重新检查任务
+	notified_.store(false, std::memory_order::memory_order_release);
 }
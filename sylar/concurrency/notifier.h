@@ -1,20 +1,23 @@
 #pragma once
 
+#include <atomic>
 #include <sys/eventfd.h>
 
 namespace sylar {
 namespace concurrency {
 
-class EpollPoller;
+class Poller;
 
+/// @brief 用于唤醒阻塞于 poller 的线程
+///
+///		   eventfd 工作于非信号量模式，且在被处理前的多次 Notify 只会写入一次
 class Notifier {
 public:
-	Notifier(EpollPoller* owner);
+	Notifier(Poller* owner);
 
 	~Notifier() noexcept;
 
-	/// @brief 信号量累加 @a num
-	void Notify(uint64_t num = 1);
+	void Notify();
 
 	int GetEventFd()
 	{ return eventFd_; }
@@ -22,8 +25,10 @@ public:
 	void HandleEventFd();
 
 private:
-	EpollPoller* owner_;
+	Poller* owner_;
 	int eventFd_;
+	/// @brief 是否已写入且尚未被处理
+	std::atomic<bool> notified_ {false};
 };
 
 } // namespace concurrency
@@ -0,0 +1,55 @@
+#include <concurrency/parker.h>
+#include <base/log.h>
+
+#include <cstring>
+#include <cstdint>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto sys_logger = SYLAR_SYS_LOGGER();
+
+cc::Parker::Parker()
+	: eventFd_(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+	if (eventFd_ < 0) {
+		SYLAR_LOG_FATAL(sys_logger) << "failed to create eventfd object, about to exit" << std::endl;
+		std::abort();
+	}
+}
+
+cc::Parker::~Parker() noexcept {
+	::close(eventFd_);
+}
+
+void cc::Parker::Park(int timeout_ms) {
+	struct ::pollfd pfd;
+	pfd.fd = eventFd_;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+	int ret = ::poll(&pfd, 1, timeout_ms);
+	if (__builtin_expect(ret < 0 && errno != EINTR, 0)) {
+		SYLAR_LOG_ERROR(sys_logger) << "failed to invoke ::poll on eventfd object"
+			<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+	}
+
+	if (ret > 0) {
+		uint64_t value = 0;
+		if (__builtin_expect(::read(eventFd_, &value, sizeof value) < 0 && errno != EAGAIN, 0)) {
+			SYLAR_LOG_WARN(sys_logger) << "failed to invoke ::read on eventfd object"
+				<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+		}
+	}
+}
+
+void cc::Parker::Unpark() {
+	uint64_t value = 1;
+	if (__builtin_expect(::write(eventFd_, &value, sizeof value) < 0, 0)) {
+		SYLAR_LOG_ERROR(sys_logger) << "failed to invoke ::write on eventfd object"
+			<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+namespace sylar {
+namespace concurrency {
+
+/// @brief 线程私有的阻塞/唤醒原语，基于非信号量模式的 eventfd
+///
+///		   - Unpark 可先于 Park 发生，此时下一次 Park 立即返回
+///		   - 多次 Unpark 会被合并为一次
+class Parker {
+public:
+	Parker();
+
+	~Parker() noexcept;
+
+	/// @brief 阻塞当前线程，直至被 Unpark 或超时
+	/// @param timeout_ms  超时时间，-1 表示不超时
+	void Park(int timeout_ms);
+
+	/// @brief 唤醒阻塞于 Park 的线程，任意线程可调用
+	void Unpark();
+
+	int GetEventFd() const
+	{ return eventFd_; }
+
+private:
+	Parker(const Parker&) = delete;
+	Parker& operator=(const Parker&) = delete;
+
+private:
+	int eventFd_;
+};
+
+} // namespace concurrency
+} // namespace sylar
@@ -0,0 +1,55 @@
+#include <concurrency/poller.h>
+#include <concurrency/notifier.h>
+#include <concurrency/timer_manager.h>
+
+namespace cc = sylar::concurrency;
+
+cc::PollBatchStats& cc::PollBatchStats::operator+=(const PollBatchStats& other) {
+	for (size_t i = 0; i < kBucketNum; ++i) {
+		buckets[i] += other.buckets[i];
+	}
+	full_batches += other.full_batches;
+	return *this;
+}
+
+cc::Poller::Poller(Scheduler* owner, Backend backend)
+	: owner_(owner)
+	, backend_(backend)
+{
+	for (auto& bucket : batchBuckets_) {
+		bucket.store(0, std::memory_order::memory_order_relaxed);
+	}
+}
+
+cc::Poller::~Poller() noexcept = default;
+
+cc::TimerManager* cc::Poller::CreateTimerManager() {
+	extraTimerManagers_.emplace_back(std::make_unique<TimerManager>(this));
+	WatchTimerManager(extraTimerManagers_.back().get());
+	return extraTimerManagers_.back().get();
+}
+
+cc::PollBatchStats cc::Poller::GetBatchStats() const {
+	PollBatchStats stats;
+	for (size_t i = 0; i < PollBatchStats::kBucketNum; ++i) {
+		stats.buckets[i] = batchBuckets_[i].load(std::memory_order::memory_order_relaxed);
+	}
+	stats.full_batches = fullBatches_.load(std::memory_order::memory_order_relaxed);
+	return stats;
+}
+
+void cc::Poller::RecordBatch(size_t num, bool full) {
+	if (num == 0) {
+		return;
+	}
+
+	// floor(log2(num))
+	size_t index = 63 - static_cast<size_t>(__builtin_clzll(num));
+	if (index >= PollBatchStats::kBucketNum) {
+		index = PollBatchStats::kBucketNum - 1;
+	}
+	batchBuckets_[index].fetch_add(1, std::memory_order::memory_order_relaxed);
+	if (full) {
+		fullBatches_.fetch_add(1, std::memory_order::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+namespace sylar {
+namespace concurrency {
+
+class Scheduler;
+class Notifier;
+class TimerManager;
+
+/// @brief 每次等待返回的就绪事件(或完成事件)数的分布
+struct PollBatchStats {
+	static constexpr size_t kBucketNum = 16;
+
+	/// @brief 第 i 个桶统计返回 [2^i, 2^(i+1)) 个事件的次数，最后一个桶包含更大的值
+	std::array<uint64_t, kBucketNum> buckets {};
+	/// @brief 返回的事件填满了缓冲区的次数
+	uint64_t full_batches = 0;
+
+	PollBatchStats& operator+=(const PollBatchStats& other);
+};
+
+/// @brief IO 多路复用器的公共接口
+///
+///		   兴趣事件沿用 EPOLLIN/EPOLLOUT 等取值，与 poll(2) 的 POLLIN/POLLOUT 一致；
+///		   每个 poller 各自持有一个 Notifier 与一个 TimerManager，并可等待更多 TimerManager 的 timerfd
+class Poller {
+public:
+	enum class Backend : uint8_t {
+		kEpoll,
+		kIoUring
+	};
+
+	explicit Poller(Scheduler* owner, Backend backend);
+
+	virtual ~Poller() noexcept;
+
+	/// @brief Poll and handle ready events, wrap events as a coroutine
+	virtual void PollAndHandle() = 0;
+
+	/// @brief 不阻塞地处理已就绪的事件
+	/// @return 处理的事件数
+	virtual size_t TryPollAndHandle() = 0;
+
+	/// @brief Append events to the specified fd
+	/// @param fd  target fd
+	/// @param interest_events  the registered events
+	/// @param func  the callback associaled the events, if empty, resume the current coroutine
+	virtual void AppendEvent(int fd, unsigned interest_events, std::function<void()> func) = 0;
+
+	virtual void UpdateEvent(int fd, unsigned interest_events, std::function<void()> func) = 0;
+
+	virtual void CancelEvent(int fd, unsigned target_events) = 0;
+
+	Backend GetBackend() const
+	{ return backend_; }
+
+	Scheduler* GetScheduler() const
+	{ return owner_; }
+
+	Notifier* GetNotifier() const
+	{ return notifier_.get(); }
+
+	TimerManager* GetTimerManager() const
+	{ return timerManager_.get(); }
+
+	/// @brief 新建一个 TimerManager，其 timerfd 由该 poller 等待，生命周期与该 poller 相同
+	///
+	///		   single-reactor 模式下各调度线程的 TimerManager 共用同一个 poller；需在调度器启动前调用
+	TimerManager* CreateTimerManager();
+
+	PollBatchStats GetBatchStats() const;
+
+	/// @brief 所在线程正以 TryPollAndHandle 忙轮询时，唤醒者无需再通过 Notifier 唤醒它
+	void SetBusyPolling(bool busy_polling)
+	{ busyPolling_.store(busy_polling, std::memory_order::memory_order_seq_cst); }
+
+	bool IsBusyPolling() const
+	{ return busyPolling_.load(std::memory_order::memory_order_seq_cst); }
+
+protected:
+	/// @brief 记录一次等待返回的事件数 @a num，@a full 表示是否填满了缓冲区
+	void RecordBatch(size_t num, bool full);
+
+	/// @brief 开始等待 @a timer_manager 的 timerfd，其可读时调用 TimerManager::HandleExpiredTimers
+	virtual void WatchTimerManager(TimerManager* timer_manager) = 0;
+
+private:
+	Poller(const Poller&) = delete;
+	Poller& operator=(const Poller&) = delete;
+
+	std::array<std::atomic<uint64_t>, PollBatchStats::kBucketNum> batchBuckets_;
+	std::atomic<uint64_t> fullBatches_ {0};
+	std::atomic<bool> busyPolling_ {false};
+
+protected:
+	concurrency::Scheduler* const owner_;
+	const Backend backend_;
+	std::unique_ptr<concurrency::Notifier> notifier_;
+	std::unique_ptr<concurrency::TimerManager> timerManager_;
+	std::vector<std::unique_ptr<concurrency::TimerManager>> extraTimerManagers_;
+};
+
+} // namespace concurrency
+} // namespace sylar
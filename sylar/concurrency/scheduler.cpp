@@ -2,13 +2,107 @@
 #include <concurrency/thread.h>
 #include <concurrency/notifier.h>
 #include <concurrency/epoll_poller.h>
+#ifdef SYLAR_IO_URING
+#include <concurrency/io_uring_poller.h>
+#endif
 #include <concurrency/timer_manager.h>
 #include <concurrency/hook.h>
+#include <base/clock.h>
 #include <base/debug.h>
+#include <base/config.h>
+
+#include <sched.h>
+#include <algorithm>
 
 using namespace sylar;
 namespace cc = sylar::concurrency;
 
+namespace {
+
+static auto g_use_shared_stack = base::Singleton<base::ConfigManager>::GetInstance()
+		.AddOrUpdate<bool>("scheduler.shared_stack", false, "run callback tasks on the per-thread shared stack");
+
+static auto g_multi_reactor = base::Singleton<base::ConfigManager>::GetInstance()
+		.AddOrUpdate<bool>("scheduler.multi_reactor", false, "give each scheduling thread its own poller and shard fds among them");
+
+static auto g_poller_backend = base::Singleton<base::ConfigManager>::GetInstance()
+		.AddOrUpdate<std::string>("scheduler.poller", "epoll", "io multiplexing backend: epoll or io_uring, io_uring falls back to epoll if unsupported");
+
+/// @brief follower 阻塞于 Parker 的超时时间
+static constexpr int kParkTimeoutMs = 5000;
+
+/// @brief 每个线程缓存的任务节点数量上限
+static constexpr size_t kTaskCacheCap = 1024;
+
+/// @brief 当前线程的任务节点缓存是否已被销毁
+thread_local static bool tl_task_cache_destroyed = false;
+
+static std::atomic<uint64_t> s_idle_spin_us {0};
+static std::atomic<uint32_t> s_idle_yield_num {0};
+static std::atomic<uint64_t> s_busy_poll_idle_us {0};
+
+struct __InitSchedulerIdleConfigHelper {
+	__InitSchedulerIdleConfigHelper() {
+		auto& config = base::Singleton<base::ConfigManager>::GetInstance();
+
+		auto spin_us = config.AddOrUpdate<uint64_t>("scheduler.idle.spin_us",
+				s_idle_spin_us.load(), "microseconds an idle scheduling thread spins on the run queues before parking");
+		spin_us->AddMonitor([](const uint64_t&, const uint64_t& now) {
+			s_idle_spin_us.store(now, std::memory_order::memory_order_relaxed);
+		});
+
+		auto yield_num = config.AddOrUpdate<uint32_t>("scheduler.idle.yield_num",
+				s_idle_yield_num.load(), "times an idle scheduling thread yields the cpu after spinning and before parking");
+		yield_num->AddMonitor([](const uint32_t&, const uint32_t& now) {
+			s_idle_yield_num.store(now, std::memory_order::memory_order_relaxed);
+		});
+
+		auto busy_poll_idle_us = config.AddOrUpdate<uint64_t>("scheduler.busy_poll.idle_us",
+				s_busy_poll_idle_us.load(), "microseconds the polling thread keeps polling without blocking after it runs out of work, 0 disables busy polling");
+		busy_poll_idle_us->AddMonitor([](const uint64_t&, const uint64_t& now) {
+			s_busy_poll_idle_us.store(now, std::memory_order::memory_order_relaxed);
+		});
+	}
+};
+
+static __InitSchedulerIdleConfigHelper s_init_scheduler_idle_config_helper {};
+
+static inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+/// @brief 共享栈协程只能在其绑定的线程上被换入，绑定的线程优先于指定的线程
+static ::pthread_t ResolveTargetThread(const std::shared_ptr<cc::Coroutine>& co, ::pthread_t pthread_id) {
+	if (co && co->GetBoundThread() != INVALID_PTHREAD_ID) {
+		return co->GetBoundThread();
+	}
+	return pthread_id;
+}
+
+/// @brief 按配置创建 poller，内核不支持 io_uring 时退回 epoll
+static std::unique_ptr<cc::Poller> CreatePoller(cc::Scheduler* owner) {
+	const std::string backend = g_poller_backend->GetValue();
+	if (backend == "io_uring") {
+#ifdef SYLAR_IO_URING
+		if (cc::IoUringPoller::IsSupported()) {
+			return std::make_unique<cc::IoUringPoller>(owner);
+		}
+		SYLAR_LOG_WARN(SYLAR_SYS_LOGGER()) << "io_uring is unsupported by the kernel, fall back to epoll" << std::endl;
+#else
+		SYLAR_LOG_WARN(SYLAR_SYS_LOGGER()) << "built without io_uring, fall back to epoll" << std::endl;
+#endif
+	} else if (backend != "epoll") {
+		SYLAR_LOG_WARN(SYLAR_SYS_LOGGER()) << "unknown poller backend " << backend << ", use epoll" << std::endl;
+	}
+	return std::make_unique<cc::EpollPoller>(owner);
+}
+
+} // namespace
+
 namespace sylar {
 namespace concurrency {
 namespace this_thread {
@@ -19,6 +113,23 @@ static thread_local cc::Scheduler* tl_scheduler = nullptr;
 /// @brief 当前线程负责调度(任务)协程的(调度)协程对象
 static thread_local cc::Coroutine* tl_scheduling_coroutine = nullptr;
 
+/// @brief 当前调度线程在其Scheduler实例中的下标
+static thread_local size_t tl_worker_index = static_cast<size_t>(-1);
+
+/// @brief 用于随机选取窃取对象
+static thread_local uint64_t tl_steal_seed = 0;
+
+static uint64_t NextRandom() {
+	if (__builtin_expect(tl_steal_seed == 0, 0)) {
+		tl_steal_seed = static_cast<uint64_t>(base::GetTid()) * 0x9E3779B97F4A7C15ull | 1;
+	}
+	// xorshift64
+	tl_steal_seed ^= tl_steal_seed << 13;
+	tl_steal_seed ^= tl_steal_seed >> 7;
+	tl_steal_seed ^= tl_steal_seed << 17;
+	return tl_steal_seed;
+}
+
 static void SetSchedulingCoroutine(cc::Coroutine* co) {
 	if (co) {
 		SYLAR_ASSERT_WITH_MSG(tl_scheduling_coroutine == nullptr,
@@ -51,18 +162,64 @@ cc::Scheduler::Scheduler(size_t thread_num, bool include_cur_thread, std::string
 	: name_(std::move(name))
 	, dummyMainCoroutine_(nullptr)
 	, dummyMainTrdPthreadId_(include_cur_thread ? base::GetPthreadId() : INVALID_PTHREAD_ID)
-	, poller_(std::make_unique<cc::EpollPoller>(this))
+	, multiReactor_(g_multi_reactor->GetValue())
 	, threadPool_((include_cur_thread ? thread_num - 1 : thread_num))
+	, parkedMask_(new std::atomic<uint64_t>[(thread_num + 63) / 64])
+	, parkedMaskWords_((thread_num + 63) / 64)
 {
+	for (size_t i = 0; i < parkedMaskWords_; ++i) {
+		parkedMask_[i].store(0, std::memory_order::memory_order_relaxed);
+	}
+
+	for (size_t i = 0; i < thread_num; ++i) {
+		workers_.emplace_back(std::make_unique<Worker>(i));
+	}
+
+	if (multiReactor_) {
+		for (size_t i = 0; i < thread_num; ++i) {
+			pollers_.emplace_back(CreatePoller(this));
+			workers_[i]->poller = pollers_.back().get();
+		}
+		// dummy-main 线程仅在 Stop 时参与调度，不为其分配 fd
+		shardNum_ = include_cur_thread && thread_num > 1 ? thread_num - 1 : thread_num;
+	} else {
+		pollers_.emplace_back(CreatePoller(this));
+	}
+
+	// 每个调度线程各自的 TimerManager 由其所属的 poller 等待，single-reactor 模式下均为首个 poller
+	SYLAR_ASSERT(thread_num < (1u << Timer::kIdTagBits));
+	timerManagers_.push_back(GetPrimaryPoller()->GetTimerManager());
+	for (auto& worker : workers_) {
+		Poller* poller = worker->poller ? worker->poller : GetPrimaryPoller();
+		worker->timer_manager = poller->CreateTimerManager();
+		worker->timer_manager->SetIdTag(static_cast<uint8_t>(timerManagers_.size()));
+		timerManagers_.push_back(worker->timer_manager);
+	}
+
 	if (include_cur_thread) {
+		workers_.back()->pthread_id.store(dummyMainTrdPthreadId_, std::memory_order::memory_order_relaxed);
 		cc::this_thread::GetMainCoroutine();
 		cc::this_thread::SetSchedulingCoroutine(dummyMainCoroutine_.get());
-		dummyMainCoroutine_ = std::make_shared<cc::Coroutine>(std::bind(&Scheduler::SchedulingFunc, this), 1024 * 10, true);
+		// dummy-main 协程使用最后一个 Worker
+		dummyMainCoroutine_ = std::make_shared<cc::Coroutine>(
+				std::bind(&Scheduler::SchedulingFunc, this, thread_num - 1), 1024 * 10, true);
 	}
 }
 
 cc::Scheduler::~Scheduler() noexcept {
 	SYLAR_ASSERT(this->IsStopped());
+
+	for (auto task : injectQueue_) {
+		DeleteTask(task);
+	}
+	for (auto& worker : workers_) {
+		while (auto task = worker->run_queue.Pop()) {
+			DeleteTask(task);
+		}
+		while (auto task = worker->mailbox.Pop()) {
+			DeleteTask(task);
+		}
+	}
 }
 
 void cc::Scheduler::Start() {
@@ -70,8 +227,8 @@ void cc::Scheduler::Start() {
 	if (stopped_.compare_exchange_strong(expected, false, std::memory_order::memory_order_acq_rel)) {
 		for (size_t i = 0; i < threadPool_.size(); ++i) {
 			threadPool_[i].reset(new cc::Thread(
-				[this]() {
-					this->SchedulingFunc();
+				[this, i]() {
+					this->SchedulingFunc(i);
 				}, name_ + "_" + std::to_string(i)
 			));
 		}
@@ -90,11 +247,7 @@ void cc::Scheduler::Stop() {
 		return;
 	}
 
-	Notify(threadPool_.size());
-
-	if (dummyMainCoroutine_) {
-		Notify();
-	}
+	WakeAll();
 
 	if (dummyMainCoroutine_) {
 		dummyMainCoroutine_->SwapIn();
@@ -112,15 +265,247 @@ void cc::Scheduler::Stop() {
 }
 
 bool cc::Scheduler::IsStopped() const {
-	std::lock_guard<std::mutex> guard(mutex_);
-    return stopped_ && taskList_.empty();
+    return stopped_ && !HasPendingTask();
+}
+
+bool cc::Scheduler::HasPendingTask() const {
+	if (injectQueueSize_.load(std::memory_order::memory_order_relaxed) > 0) {
+		return true;
+	}
+
+	for (const auto& worker : workers_) {
+		if (!worker->run_queue.Empty() || !worker->mailbox.Empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool cc::Scheduler::HasRunnableTask(const Worker* worker) const {
+	if (!worker->mailbox.Empty()
+			|| injectQueueSize_.load(std::memory_order::memory_order_relaxed) > 0)
+	{
+		return true;
+	}
+
+	// 其他线程运行队列中的任务可被窃取
+	for (const auto& w : workers_) {
+		if (!w->run_queue.Empty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+cc::Scheduler::Worker* cc::Scheduler::GetThisWorker() const {
+	if (cc::this_thread::GetScheduler() != this) {
+		return nullptr;
+	}
+	return workers_[cc::this_thread::tl_worker_index].get();
 }
 
-void cc::Scheduler::SchedulingFunc() {
+cc::Scheduler::Worker* cc::Scheduler::FindWorker(::pthread_t pthread_id) const {
+	for (const auto& worker : workers_) {
+		if (worker->pthread_id.load(std::memory_order::memory_order_relaxed) == pthread_id) {
+			return worker.get();
+		}
+	}
+	return nullptr;
+}
+
+void cc::Scheduler::Submit(InvocableWrapper* task) {
+	SYLAR_ASSERT(task->coroutine || task->callback);
+
+	Worker* worker = GetThisWorker();
+
+	if (task->target_thread != INVALID_PTHREAD_ID) {
+		Worker* target = FindWorker(task->target_thread);
+		SYLAR_ASSERT_WITH_MSG(target != nullptr,
+				"the target thread is not a scheduling thread of this scheduler");
+
+		target->mailbox.Push(task);
+		if (target != worker) {
+			// 与 HandleIdle 中阻塞前的检查配对，避免丢失唤醒
+			std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);
+			Wake(target);
+		}
+		return;
+	}
+
+	if (worker) {
+		worker->run_queue.Push(task);
+	} else {
+		std::lock_guard<std::mutex> guard(injectMutex_);
+		injectQueue_.push_back(task);
+		injectQueueSize_.fetch_add(1, std::memory_order::memory_order_relaxed);
+	}
+
+	// 与 SchedulingFunc 中进入空闲前的检查配对，避免丢失唤醒
+	std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);
+	if (idleThreadNum_.load(std::memory_order::memory_order_relaxed) > 0) {
+		Notify();
+	}
+}
+
+void cc::Scheduler::Co(TaskBatch& batch) {
+	if (batch.Empty()) {
+		return;
+	}
+
+	Worker* worker = GetThisWorker();
+	std::vector<InvocableWrapper*> generic_tasks;
+	std::vector<Worker*> targets;
+	generic_tasks.reserve(batch.tasks_.size());
+
+	for (auto task : batch.tasks_) {
+		SYLAR_ASSERT(task->coroutine || task->callback);
+		if (task->target_thread == INVALID_PTHREAD_ID) {
+			generic_tasks.push_back(task);
+			continue;
+		}
+
+		Worker* target = FindWorker(task->target_thread);
+		SYLAR_ASSERT_WITH_MSG(target != nullptr,
+				"the target thread is not a scheduling thread of this scheduler");
+		target->mailbox.Push(task);
+		if (target != worker && std::find(targets.begin(), targets.end(), target) == targets.end()) {
+			targets.push_back(target);
+		}
+	}
+	batch.tasks_.clear();
+
+	if (worker) {
+		for (auto task : generic_tasks) {
+			worker->run_queue.Push(task);
+		}
+	} else if (!generic_tasks.empty()) {
+		std::lock_guard<std::mutex> guard(injectMutex_);
+		injectQueue_.insert(injectQueue_.end(), generic_tasks.begin(), generic_tasks.end());
+		injectQueueSize_.fetch_add(generic_tasks.size(), std::memory_order::memory_order_relaxed);
+	}
+
+	// 与 SchedulingFunc/HandleIdle 中进入空闲前的检查配对，避免丢失唤醒
+	std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);
+	for (auto target : targets) {
+		Wake(target);
+	}
+	if (!generic_tasks.empty()) {
+		size_t idle_num = idleThreadNum_.load(std::memory_order::memory_order_relaxed);
+		if (idle_num > 0) {
+			Notify(std::min(generic_tasks.size(), idle_num));
+		}
+	}
+}
+
+cc::Scheduler::TaskBatch::~TaskBatch() noexcept {
+	for (auto task : tasks_) {
+		DeleteTask(task);
+	}
+}
+
+/// @brief 线程局部的任务节点缓存
+///
+///		   节点由提交任务的线程取出、由执行任务的线程放回，调度线程上提交并执行的任务因此不再分配内存；
+///		   非调度线程提交的任务所用的节点最终留在调度线程的缓存中
+struct cc::Scheduler::TaskCache {
+	~TaskCache() noexcept {
+		for (auto task : tasks) {
+			delete task;
+		}
+		tl_task_cache_destroyed = true;
+	}
+
+	std::vector<InvocableWrapper*> tasks;
+};
+
+cc::Scheduler::TaskCache* cc::Scheduler::GetThisThreadTaskCache() {
+	if (__builtin_expect(tl_task_cache_destroyed, 0)) {
+		return nullptr;
+	}
+	thread_local static TaskCache tl_task_cache;
+	return &tl_task_cache;
+}
+
+cc::Scheduler::InvocableWrapper* cc::Scheduler::TakeCachedTask() {
+	TaskCache* cache = GetThisThreadTaskCache();
+	if (!cache || cache->tasks.empty()) {
+		return nullptr;
+	}
+	InvocableWrapper* task = cache->tasks.back();
+	cache->tasks.pop_back();
+	return task;
+}
+
+void cc::Scheduler::DeleteTask(InvocableWrapper* task) {
+	TaskCache* cache = GetThisThreadTaskCache();
+	if (!cache || cache->tasks.size() >= kTaskCacheCap) {
+		delete task;
+		return;
+	}
+	// 在放回前释放回调函数及协程所持有的资源
+	task->Reset();
+	cache->tasks.push_back(task);
+}
+
+cc::Scheduler::InvocableWrapper* cc::Scheduler::TakeTask(Worker* worker) {
+	// 1. 自身邮箱，其中的任务只能由当前线程执行
+	InvocableWrapper* task = worker->mailbox.Pop();
+	if (task) {
+		return task;
+	}
+
+	// 2. 自身运行队列
+	task = worker->run_queue.Pop();
+	if (task) {
+		return task;
+	}
+
+	// 3. 全局注入队列
+	if (injectQueueSize_.load(std::memory_order::memory_order_relaxed) > 0) {
+		std::lock_guard<std::mutex> guard(injectMutex_);
+		if (!injectQueue_.empty()) {
+			task = injectQueue_.front();
+			injectQueue_.pop_front();
+			injectQueueSize_.fetch_sub(1, std::memory_order::memory_order_relaxed);
+			return task;
+		}
+	}
+
+	// 4. 窃取其他调度线程的任务
+	return StealTask(worker);
+}
+
+cc::Scheduler::InvocableWrapper* cc::Scheduler::StealTask(Worker* thief) {
+	const size_t worker_num = workers_.size();
+	if (worker_num <= 1) {
+		return nullptr;
+	}
+
+	const size_t start = cc::this_thread::NextRandom() % worker_num;
+	for (size_t i = 0; i < worker_num; ++i) {
+		Worker* victim = workers_[(start + i) % worker_num].get();
+		if (victim == thief) {
+			continue;
+		}
+
+		InvocableWrapper* task = victim->run_queue.Steal();
+		if (task) {
+			return task;
+		}
+	}
+	return nullptr;
+}
+
+void cc::Scheduler::SchedulingFunc(size_t worker_index) {
 	// set the scheduler(this)
 	cc::this_thread::SetScheduler(this);
+	cc::this_thread::tl_worker_index = worker_index;
+	Worker* const worker = workers_[worker_index].get();
+	worker->pthread_id.store(base::GetPthreadId(), std::memory_order::memory_order_relaxed);
 
 	cc::this_thread::EnableHook(true);
+	// 任务与定时器在毫秒精度内共用每次取得任务时读取的时间
+	base::CachedClock::SetThreadCached(true);
 
 	// create main coroutine for current (each) thread
 	auto scheduling_coroutine = cc::this_thread::GetMainCoroutine();
@@ -137,50 +522,30 @@ void cc::Scheduler::SchedulingFunc() {
 	}
 
 	// create idle_coroutine to handle idle event
-	auto idle_coroutine = std::make_shared<cc::Coroutine>(std::bind(&Scheduler::HandleIdle, this));
+	auto idle_coroutine = std::make_shared<cc::Coroutine>(std::bind(&Scheduler::HandleIdle, this, worker));
 
-	// pointer to the temp coroutine, to wrap a callback be executed as a coroutine
-	std::shared_ptr<cc::Coroutine> temp_coroutine;
+	// callback tasks are wrapped as coroutines acquired from the per-thread recycler
+	const bool use_shared_stack = g_use_shared_stack->GetValue();
 
 	InvocableWrapper current_task {};
 	while (true) {
-		bool has_task = false;
-		bool need_notify = false;
 		current_task.Reset();
-		{
-			std::lock_guard<std::mutex> guard(mutex_);
-			decltype(taskList_)::iterator it;
-			for (it = taskList_.begin(); it != taskList_.end(); ++it) {
-				if (it->target_thread != INVALID_PTHREAD_ID
-						&& it->target_thread != base::GetPthreadId())
-				{
-					need_notify = true;
-					continue;
-				}
 
-				SYLAR_ASSERT(it->coroutine || it->callback);
-				/// FIXME:
-				///		concurrency::Coroutine并不满足线程安全结构，
-				///		因此一个协程对象同一时刻，只能被一个线程所执行。
-				///		pending列表类型应该由vector->set
-				/// 	以下断言并不能避免协程被多个线程执行，因为该协程
-				///     或许被其他scheduling coroutine获取，并即将执行，
-				///		只是还未改变状态
-				if (it->coroutine) {
-					SYLAR_ASSERT(it->coroutine->GetState() != Coroutine::State::kExec);
-				}
-				current_task = std::move(*it);
-				taskList_.erase(it);
-				has_task = true;
-				break;
+		InvocableWrapper* task = TakeTask(worker);
+		StopSearching(worker, task != nullptr);
+		if (task) {
+			base::CachedClock::Refresh();
+			/// FIXME:
+			///		concurrency::Coroutine并不满足线程安全结构，
+			///		因此一个协程对象同一时刻，只能被一个线程所执行。
+			/// 	以下断言并不能避免协程被多个线程执行，因为该协程
+			///     或许被其他scheduling coroutine获取，并即将执行，
+			///		只是还未改变状态
+			if (task->coroutine) {
+				SYLAR_ASSERT(task->coroutine->GetState() != Coroutine::State::kExec);
 			}
-
-			need_notify = need_notify || !taskList_.empty();
-		}
-
-		if (need_notify) {
-			// 只通知一个线程获取任务，避免多个线程竞争锁，并将唤醒的责任移交给它
-			Notify();
+			current_task = std::move(*task);
+			DeleteTask(task);
 		}
 
 		if (current_task.coroutine &&
@@ -192,7 +557,7 @@ void cc::Scheduler::SchedulingFunc() {
 			--activeThreadNum_;
 
 			if (current_task.coroutine->GetState() == cc::Coroutine::State::kReady) {
-				// add to list again (need a lock here, optimize it)
+				// push to the run queue of current worker again
 				Co(std::move(current_task.coroutine));
 			} else if (current_task.coroutine->GetState() != cc::Coroutine::State::kTerminal
 					&& current_task.coroutine->GetState() != cc::Coroutine::State::kExcept)
@@ -200,40 +565,46 @@ void cc::Scheduler::SchedulingFunc() {
 				/// TODO:
 				/// 	协程的状态交由用户管理，对于非法状态应当报错或警告
 				current_task.coroutine->SetState(cc::Coroutine::State::kHold);
-			}
-		} else if (current_task.callback) {
-			if (temp_coroutine) {
-				temp_coroutine->Reset(std::move(current_task.callback));
 			} else {
-				temp_coroutine = std::make_shared<cc::Coroutine>(std::move(current_task.callback));
+				// 无其他引用时(如曾被挂起的回调协程)回收复用
+				cc::this_thread::RecycleCoroutine(std::move(current_task.coroutine));
 			}
+		} else if (current_task.callback) {
 			// invoke it by warp it o a coroutine
+			auto temp_coroutine = cc::this_thread::AcquireCoroutine(std::move(current_task.callback), use_shared_stack);
 			++activeThreadNum_;
 			temp_coroutine->SwapIn();
 			--activeThreadNum_;
 
 			if (temp_coroutine->GetState() == cc::Coroutine::State::kReady) {
-				// add to list again (need a lock here, optimize it)
+				// push to the run queue of current worker again
 				Co(std::move(temp_coroutine));
 			} else if (temp_coroutine->GetState() == cc::Coroutine::State::kTerminal
 					|| temp_coroutine->GetState() == cc::Coroutine::State::kExcept)
 			{
-				temp_coroutine->Reset(nullptr);
+				cc::this_thread::RecycleCoroutine(std::move(temp_coroutine));
 			} else {
+				// 已被他处(如 poller)持有，等待被再次调度
 				temp_coroutine->SetState(cc::Coroutine::State::kHold);
-				temp_coroutine.reset();
 			}
 		} else {
-			if (has_task) {
-				continue;
-			}
-
 			if (idle_coroutine->GetState() == cc::Coroutine::State::kTerminal) {
 				SYLAR_LOG_INFO(SYLAR_ROOT_LOGGER()) << "idle coroutine is terminal" << std::endl;
 				break;
 			}
 
+			if (SpinForTask(worker)) {
+				continue;
+			}
+
+			// 先登记为空闲再复查，与 Submit 配对，避免任务提交者错过唤醒
 			++idleThreadNum_;
+			std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);
+			if (HasRunnableTask(worker)) {
+				--idleThreadNum_;
+				continue;
+			}
+
 			idle_coroutine->SwapIn();
 			--idleThreadNum_;
 			if (idle_coroutine->GetState() != cc::Coroutine::State::kTerminal
@@ -244,23 +615,251 @@ void cc::Scheduler::SchedulingFunc() {
 		}
 	}
 
+	// 使仍处于空闲的线程重新检查调度器的状态
+	WakeAll();
+
 	cc::this_thread::SetSchedulingCoroutine(nullptr);
+	cc::this_thread::tl_worker_index = static_cast<size_t>(-1);
 	cc::this_thread::SetScheduler(nullptr);
+	base::CachedClock::SetThreadCached(false);
+}
+
+bool cc::Scheduler::SpinForTask(Worker* worker) {
+	const uint64_t spin_us = s_idle_spin_us.load(std::memory_order::memory_order_relaxed);
+	const uint32_t yield_num = s_idle_yield_num.load(std::memory_order::memory_order_relaxed);
+	if ((spin_us == 0 && yield_num == 0) || stopped_.load(std::memory_order::memory_order_relaxed)) {
+		return false;
+	}
+
+	if (!worker->searching.load(std::memory_order::memory_order_relaxed)) {
+		if (2 * searchingThreadNum_.load(std::memory_order::memory_order_relaxed) >= workers_.size()) {
+			return false;
+		}
+		worker->searching.store(true, std::memory_order::memory_order_relaxed);
+		searchingThreadNum_.fetch_add(1, std::memory_order::memory_order_seq_cst);
+	}
+
+	// 找到任务时保持搜索状态，由获取任务后的 StopSearching 结束
+	if (spin_us > 0) {
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(spin_us);
+		do {
+			for (int i = 0; i < 64; ++i) {
+				CpuRelax();
+			}
+			if (HasRunnableTask(worker)) {
+				worker->spin_hits.fetch_add(1, std::memory_order::memory_order_relaxed);
+				return true;
+			}
+		} while (std::chrono::steady_clock::now() < deadline);
+	}
+
+	for (uint32_t i = 0; i < yield_num; ++i) {
+		::sched_yield();
+		if (HasRunnableTask(worker)) {
+			worker->yield_hits.fetch_add(1, std::memory_order::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	worker->spin_misses.fetch_add(1, std::memory_order::memory_order_relaxed);
+	StopSearching(worker, false);
+	return false;
 }
 
-void cc::Scheduler::HandleIdle() {
+void cc::Scheduler::HandleIdle(Worker* worker) {
 	SYLAR_LOG_INFO(SYLAR_ROOT_LOGGER()) << "Scheduler::HandleIdle is invoked" << std::endl;
 
 	while (!IsStopped()) {
-		poller_->PollAndHandle();
+		bool expected = false;
+		const bool is_leader = !multiReactor_ && hasPollingLeader_.compare_exchange_strong(expected, true,
+				std::memory_order::memory_order_acq_rel);
+		if (is_leader) {
+			worker->idle_state.store(Worker::IdleState::kPolling, std::memory_order::memory_order_relaxed);
+		} else {
+			worker->idle_state.store(Worker::IdleState::kParked, std::memory_order::memory_order_relaxed);
+			MarkParked(worker);
+		}
+
+		// 先公开空闲状态再复查，与 Submit 配对，避免任务提交者错过唤醒
+		std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);
+		if (!HasRunnableTask(worker) && !IsStopped()) {
+			Poller* poller = is_leader ? GetPrimaryPoller() : worker->poller;
+			if (poller) {
+				if (!BusyPoll(worker, poller)) {
+					worker->polls.fetch_add(1, std::memory_order::memory_order_relaxed);
+					poller->PollAndHandle();
+				}
+			} else {
+				worker->parks.fetch_add(1, std::memory_order::memory_order_relaxed);
+				worker->parker.Park(kParkTimeoutMs);
+			}
+		}
+
+		worker->idle_state.store(Worker::IdleState::kBusy, std::memory_order::memory_order_relaxed);
+		if (is_leader) {
+			hasPollingLeader_.store(false, std::memory_order::memory_order_release);
+			// 由一个 follower 接替 leader，使 IO 事件能够被及时处理
+			UnparkOne();
+		} else {
+			// 超时或未曾阻塞时，自行移出阻塞集合；否则唤醒者已将其移出
+			ClaimParked(worker);
+		}
 
 		// swap to the scheduling coroutine
 		cc::Coroutine::YieldCurCoroutineToHold();
 	}
 }
 
-void cc::Scheduler::Notify(uint64_t num) {
-	poller_->GetNotifier()->Notify(num);
+bool cc::Scheduler::BusyPoll(Worker* worker, Poller* poller) {
+	const uint64_t idle_us = s_busy_poll_idle_us.load(std::memory_order::memory_order_relaxed);
+	if (idle_us == 0) {
+		return false;
+	}
+
+	// 与 NotifyPoller 配对: 此后提交任务者不再写 Notifier，由本线程自行发现任务
+	poller->SetBusyPolling(true);
+	bool has_task = false;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(idle_us);
+	do {
+		// 就绪事件产生的任务进入本线程的运行队列，于下一次检查时发现
+		poller->TryPollAndHandle();
+		if (HasRunnableTask(worker) || IsStopped()) {
+			has_task = true;
+			break;
+		}
+		CpuRelax();
+	} while (std::chrono::steady_clock::now() < deadline);
+	poller->SetBusyPolling(false);
+	std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);
+
+	// 清除忙轮询状态后复查，避免与认为本线程仍在忙轮询的提交者互相错过
+	if (!has_task) {
+		has_task = HasRunnableTask(worker) || IsStopped();
+	}
+	if (has_task) {
+		worker->busy_poll_hits.fetch_add(1, std::memory_order::memory_order_relaxed);
+	} else {
+		worker->busy_poll_misses.fetch_add(1, std::memory_order::memory_order_relaxed);
+	}
+	return has_task;
+}
+
+void cc::Scheduler::NotifyPoller(Poller* poller) {
+	if (!poller->IsBusyPolling()) {
+		poller->GetNotifier()->Notify();
+	}
+}
+
+void cc::Scheduler::Notify(size_t num) {
+	// 搜索中的线程会在再次空闲前重新检查任务
+	size_t searching_num = searchingThreadNum_.load(std::memory_order::memory_order_acquire);
+	if (searching_num >= num) {
+		return;
+	}
+
+	num -= searching_num;
+	while (num > 0 && UnparkOne()) {
+		--num;
+	}
+	if (num == 0) {
+		return;
+	}
+
+	Worker* worker = GetThisWorker();
+	if (worker && worker->idle_state.load(std::memory_order::memory_order_relaxed) == Worker::IdleState::kPolling) {
+		// 当前线程即为 leader(正在处理就绪事件)，返回后会重新检查任务
+		return;
+	}
+
+	if (hasPollingLeader_.load(std::memory_order::memory_order_acquire)) {
+		NotifyPoller(GetPrimaryPoller());
+	}
+}
+
+void cc::Scheduler::MarkParked(Worker* worker) {
+	parkedMask_[worker->index / 64].fetch_or(1ull << (worker->index % 64),
+			std::memory_order::memory_order_seq_cst);
+}
+
+bool cc::Scheduler::ClaimParked(Worker* worker) {
+	const uint64_t bit = 1ull << (worker->index % 64);
+	return parkedMask_[worker->index / 64].fetch_and(~bit, std::memory_order::memory_order_acq_rel) & bit;
+}
+
+void cc::Scheduler::Unpark(Worker* worker) {
+	worker->unparks.fetch_add(1, std::memory_order::memory_order_relaxed);
+	worker->searching.store(true, std::memory_order::memory_order_relaxed);
+	searchingThreadNum_.fetch_add(1, std::memory_order::memory_order_seq_cst);
+	if (worker->poller) {
+		NotifyPoller(worker->poller);
+	} else {
+		worker->parker.Unpark();
+	}
+}
+
+bool cc::Scheduler::UnparkOne() {
+	for (size_t i = 0; i < parkedMaskWords_; ++i) {
+		uint64_t mask = parkedMask_[i].load(std::memory_order::memory_order_acquire);
+		while (mask) {
+			Worker* worker = workers_[i * 64 + static_cast<size_t>(__builtin_ctzll(mask))].get();
+			if (ClaimParked(worker)) {
+				Unpark(worker);
+				return true;
+			}
+			mask &= mask - 1;
+		}
+	}
+	return false;
+}
+
+void cc::Scheduler::StopSearching(Worker* worker, bool found_task) {
+	if (!worker->searching.load(std::memory_order::memory_order_relaxed)) {
+		return;
+	}
+
+	worker->searching.store(false, std::memory_order::memory_order_relaxed);
+	size_t prev = searchingThreadNum_.fetch_sub(1, std::memory_order::memory_order_seq_cst);
+	// 最后一个搜索者获取到任务后，若仍有剩余任务，由其唤醒下一个线程接替搜索
+	if (found_task && prev == 1 && HasRunnableTask(worker)) {
+		Notify();
+	}
+}
+
+void cc::Scheduler::Wake(Worker* worker) {
+	if (ClaimParked(worker)) {
+		Unpark(worker);
+	} else if (worker->idle_state.load(std::memory_order::memory_order_acquire) == Worker::IdleState::kPolling) {
+		NotifyPoller(GetPrimaryPoller());
+	}
+}
+
+void cc::Scheduler::WakeAll() {
+	for (const auto& worker : workers_) {
+		if (ClaimParked(worker.get())) {
+			Unpark(worker.get());
+		}
+	}
+	if (hasPollingLeader_.load(std::memory_order::memory_order_acquire)) {
+		GetPrimaryPoller()->GetNotifier()->Notify();
+	}
+}
+
+cc::Poller* cc::Scheduler::GetPollerOf(int fd) const {
+	if (!multiReactor_) {
+		return GetPrimaryPoller();
+	}
+	return pollers_[static_cast<size_t>(fd) % shardNum_].get();
+}
+
+cc::IoUringPoller* cc::Scheduler::GetCompletionPoller(int fd) const {
+#ifdef SYLAR_IO_URING
+	Poller* poller = GetPollerOf(fd);
+	if (poller->GetBackend() == Poller::Backend::kIoUring) {
+		return static_cast<IoUringPoller*>(poller);
+	}
+#endif
+	(void)fd;
+	return nullptr;
 }
 
 void cc::Scheduler::AssertInSchedulingScope() const {
@@ -269,70 +868,129 @@ void cc::Scheduler::AssertInSchedulingScope() const {
 }
 
 void cc::Scheduler::AppendEvent(int fd, unsigned interest_events, std::function<void()> func) {
-	poller_->AppendEvent(fd, interest_events, std::move(func));
+	GetPollerOf(fd)->AppendEvent(fd, interest_events, std::move(func));
 }
 
 void cc::Scheduler::UpdateEvent(int fd, unsigned interest_events, std::function<void()> func) {
 	// AssertInSchedulingScope();
-	poller_->UpdateEvent(fd, interest_events, std::move(func));
+	GetPollerOf(fd)->UpdateEvent(fd, interest_events, std::move(func));
 }
 
 void cc::Scheduler::CancelEvent(int fd, unsigned target_events) {
 	// AssertInSchedulingScope();
-	poller_->CancelEvent(fd, target_events);
+	GetPollerOf(fd)->CancelEvent(fd, target_events);
+}
+
+cc::TimerManager* cc::Scheduler::GetLocalTimerManager() const {
+	Worker* worker = GetThisWorker();
+	return worker ? worker->timer_manager : timerManagers_.front();
+}
+
+cc::TimerManager* cc::Scheduler::GetTimerManagerOf(Timer::TimerId timer_id) const {
+	const uint8_t tag = Timer::GetIdTag(timer_id);
+	return tag < timerManagers_.size() ? timerManagers_[tag] : nullptr;
 }
 
-uint32_t cc::Scheduler::RunAt(std::chrono::steady_clock::time_point tp, std::function<void()> cb) {
-	Timer::TimerId id = poller_->GetTimerManager()->GetNextTimerId();
-	Timer new_timer(id, std::move(tp), cc::Timer::Interval::zero(), std::move(cb));
-	poller_->GetTimerManager()->AddTimer(std::move(new_timer));
-	return id;
+cc::Timer::TimerId cc::Scheduler::RunAt(std::chrono::steady_clock::time_point tp, std::function<void()> cb, bool non_blocking) {
+	TimerManager* timer_manager = GetLocalTimerManager();
+	Timer new_timer(TimerManager::kInvalidTimerId, std::move(tp), cc::Timer::Interval::zero(), std::move(cb), non_blocking);
+	return timer_manager->AddTimer(std::move(new_timer));
 }
 
-uint32_t sylar::concurrency::Scheduler::RunAtIf(std::chrono::steady_clock::time_point tp, std::weak_ptr<void> cond, std::function<void()> cb) {
-	Timer::TimerId id = poller_->GetTimerManager()->GetNextTimerId();
-	Timer new_timer(id, std::move(tp), cc::Timer::Interval::zero(), std::move(cb));
-	poller_->GetTimerManager()->AddConditionTimer(std::move(new_timer), std::move(cond));
-    return id;
+cc::Timer::TimerId sylar::concurrency::Scheduler::RunAtIf(std::chrono::steady_clock::time_point tp, std::weak_ptr<void> cond, std::function<void()> cb, bool non_blocking) {
+	TimerManager* timer_manager = GetLocalTimerManager();
+	Timer new_timer(TimerManager::kInvalidTimerId, std::move(tp), cc::Timer::Interval::zero(), std::move(cb), non_blocking);
+	return timer_manager->AddConditionTimer(std::move(new_timer), std::move(cond));
 }
 
-bool sylar::concurrency::Scheduler::HasTimer(uint32_t timer_id) {
-    return poller_->GetTimerManager()->HasTimer(timer_id);
+bool sylar::concurrency::Scheduler::HasTimer(Timer::TimerId timer_id) {
+	TimerManager* timer_manager = GetTimerManagerOf(timer_id);
+    return timer_manager && timer_manager->HasTimer(timer_id);
 }
 
-uint32_t cc::Scheduler::RunAfter(std::chrono::steady_clock::duration dur, std::function<void()> cb, bool repeated) {
-	auto tp = std::chrono::steady_clock::now() + dur;
+cc::Timer::TimerId cc::Scheduler::RunAfter(std::chrono::steady_clock::duration dur, std::function<void()> cb, bool repeated, bool non_blocking) {
+	// 缓存的时间可能落后于当前任务的整个运行时间，相对时长须从最新的读数算起
+	auto tp = base::CachedClock::Refresh() + dur;
 	if (repeated) {
-		Timer::TimerId id = poller_->GetTimerManager()->GetNextTimerId();
-		Timer new_timer(id, std::move(tp), std::move(dur), std::move(cb));
-		poller_->GetTimerManager()->AddTimer(std::move(new_timer));
-		return id;
+		TimerManager* timer_manager = GetLocalTimerManager();
+		Timer new_timer(TimerManager::kInvalidTimerId, std::move(tp), std::move(dur), std::move(cb), non_blocking);
+		return timer_manager->AddTimer(std::move(new_timer));
 	}
-    return RunAt(tp, std::move(cb));
+    return RunAt(tp, std::move(cb), non_blocking);
 }
 
-uint32_t sylar::concurrency::Scheduler::RunAfterIf(std::chrono::steady_clock::duration dur, std::weak_ptr<void> cond, std::function<void()> cb, bool repeated) {
-	auto tp = std::chrono::steady_clock::now() + dur;
+cc::Timer::TimerId sylar::concurrency::Scheduler::RunAfterIf(std::chrono::steady_clock::duration dur, std::weak_ptr<void> cond, std::function<void()> cb, bool repeated, bool non_blocking) {
+	auto tp = base::CachedClock::Refresh() + dur;
 	if (repeated) {
-		Timer::TimerId id = poller_->GetTimerManager()->GetNextTimerId();
-		Timer new_timer(id, std::move(tp), std::move(dur), std::move(cb));
-		poller_->GetTimerManager()->AddConditionTimer(std::move(new_timer), std::move(cond));
-		return id;
+		TimerManager* timer_manager = GetLocalTimerManager();
+		Timer new_timer(TimerManager::kInvalidTimerId, std::move(tp), std::move(dur), std::move(cb), non_blocking);
+		return timer_manager->AddConditionTimer(std::move(new_timer), std::move(cond));
+	}
+    return RunAtIf(tp, std::move(cond), std::move(cb), non_blocking);
+}
+
+cc::Timer::TimerId cc::Scheduler::RunEvery(std::chrono::steady_clock::duration interval, std::function<void()> cb, Timer::Repeat repeat, bool non_blocking) {
+	SYLAR_ASSERT(interval > std::chrono::steady_clock::duration::zero());
+	TimerManager* timer_manager = GetLocalTimerManager();
+	Timer new_timer(TimerManager::kInvalidTimerId, base::CachedClock::Refresh() + interval, interval, std::move(cb), non_blocking, repeat);
+	return timer_manager->AddTimer(std::move(new_timer));
+}
+
+void sylar::concurrency::Scheduler::CancelTimer(Timer::TimerId timer_id) {
+	if (timer_id == TimerManager::kInvalidTimerId) {
+		return;
+	}
+	TimerManager* timer_manager = GetTimerManagerOf(timer_id);
+	if (!timer_manager) {
+		return;
+	}
+	Worker* worker = GetThisWorker();
+	if (worker && worker->timer_manager != timer_manager && timer_manager != timerManagers_.front()) {
+		// 定时器属于其他调度线程，避免与其争用锁
+		timer_manager->PostCancel(timer_id);
+	} else {
+		timer_manager->CancelTimer(timer_id);
+	}
+}
+
+cc::Scheduler::IdleStats cc::Scheduler::GetIdleStats() const {
+	IdleStats stats;
+	for (const auto& worker : workers_) {
+		stats.spin_hits += worker->spin_hits.load(std::memory_order::memory_order_relaxed);
+		stats.yield_hits += worker->yield_hits.load(std::memory_order::memory_order_relaxed);
+		stats.spin_misses += worker->spin_misses.load(std::memory_order::memory_order_relaxed);
+		stats.parks += worker->parks.load(std::memory_order::memory_order_relaxed);
+		stats.unparks += worker->unparks.load(std::memory_order::memory_order_relaxed);
+		stats.polls += worker->polls.load(std::memory_order::memory_order_relaxed);
+		stats.busy_poll_hits += worker->busy_poll_hits.load(std::memory_order::memory_order_relaxed);
+		stats.busy_poll_misses += worker->busy_poll_misses.load(std::memory_order::memory_order_relaxed);
+	}
+	return stats;
+}
+
+cc::PollBatchStats cc::Scheduler::GetPollBatchStats() const {
+	PollBatchStats stats;
+	for (const auto& poller : pollers_) {
+		stats += poller->GetBatchStats();
 	}
-    return RunAtIf(tp, std::move(cond), std::move(cb));
+	return stats;
 }
 
-void sylar::concurrency::Scheduler::CancelTimer(uint32_t timer_id) {
-	poller_->GetTimerManager()->CancelTimer(timer_id);
+uint64_t cc::Scheduler::GetTimerFdSetCount() const {
+	uint64_t count = 0;
+	for (auto timer_manager : timerManagers_) {
+		count += timer_manager->GetTimerFdSetCount();
+	}
+	return count;
 }
 
 cc::Scheduler::InvocableWrapper::InvocableWrapper(const std::shared_ptr<cc::Coroutine>& co, ::pthread_t pthread_id)
-	: target_thread(pthread_id)
+	: target_thread(::ResolveTargetThread(co, pthread_id))
 	, coroutine(co)
 	{}
 
 cc::Scheduler::InvocableWrapper::InvocableWrapper(std::shared_ptr<cc::Coroutine>&& co, ::pthread_t pthread_id)
-	: target_thread(pthread_id)
+	: target_thread(::ResolveTargetThread(co, pthread_id))
 	, coroutine(std::move(co))
 	{}
 
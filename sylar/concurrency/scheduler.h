@@ -1,8 +1,15 @@
 #pragma once
 
 #include <concurrency/coroutine.h>
-
-#include <list>
+#include <concurrency/poller.h>
+#include <concurrency/work_stealing_deque.h>
+#include <concurrency/mpsc_queue.h>
+#include <concurrency/parker.h>
+#include <concurrency/timer_queue.h>
+#include <base/this_thread.h>
+
+#include <deque>
+#include <vector>
 #include <mutex>
 #include <atomic>
 #include <memory>
@@ -12,7 +19,7 @@ namespace sylar {
 namespace concurrency {
 
 class Thread;
-class EpollPoller;
+class IoUringPoller;
 
 namespace this_thread {
 
@@ -23,6 +30,20 @@ Coroutine* GetSchedulingCoroutine();
 
 class Scheduler {
 public:
+	/// @brief 调度线程空闲策略的统计，由各调度线程的计数汇总而来
+	struct IdleStats {
+		uint64_t spin_hits = 0;		///< 自旋期间等到任务的次数
+		uint64_t yield_hits = 0;	///< 让出 CPU 后等到任务的次数
+		uint64_t spin_misses = 0;	///< 自旋与让出均未等到任务的次数
+		uint64_t parks = 0;			///< 阻塞于 Parker 的次数
+		uint64_t unparks = 0;		///< 阻塞集合中的线程被唤醒的次数
+		uint64_t polls = 0;			///< 阻塞于 poller 的次数
+		uint64_t busy_poll_hits = 0;	///< 忙轮询期间等到任务的次数
+		uint64_t busy_poll_misses = 0;	///< 忙轮询超时后转为阻塞的次数
+	};
+
+	class TaskBatch;
+
     explicit Scheduler(size_t thread_num, bool include_cur_thread, std::string name);
 
 	~Scheduler() noexcept;
@@ -39,37 +60,173 @@ public:
 	template <typename Invocable>
 	void Co(Invocable&& func, pthread_t target_thread = 0);
 
+	/// @brief 批量提交 @a batch 中的所有任务，提交后 @a batch 被清空
+	///
+	///		   非指定线程的任务至多获取一次锁，且每个所需的线程至多被唤醒一次
+	void Co(TaskBatch& batch);
+	void Co(TaskBatch&& batch)
+	{ Co(batch); }
+
 	/// @brief 断言当前是否在该调度器所管理的线程中执行
 	void AssertInSchedulingScope() const;
 
+	/// @brief 是否为每个调度线程各配置一个 poller
+	///
+	///		   启用时，fd 按 fd % 线程数 分配至所属线程(home thread)，
+	///		   其事件只由所属线程的 poller 等待，就绪后的任务也只在所属线程上执行
+	bool IsMultiReactor() const
+	{ return multiReactor_; }
+
 	void AppendEvent(int fd, unsigned interest_events, std::function<void()> func);
 
 	void UpdateEvent(int fd, unsigned interest_events, std::function<void()> func);
 
 	void CancelEvent(int fd, unsigned target_events);
 
-	uint32_t RunAt(std::chrono::steady_clock::time_point tp, std::function<void()> cb);
-	uint32_t RunAtIf(std::chrono::steady_clock::time_point tp, std::weak_ptr<void> cond, std::function<void()> cb);
-	bool HasTimer(uint32_t timer_id);
-	uint32_t RunAfter(std::chrono::steady_clock::duration dur, std::function<void()> cb, bool repeated = false);
-	uint32_t RunAfterIf(std::chrono::steady_clock::duration dur, std::weak_ptr<void> cond, std::function<void()> cb, bool repeated = false);
+	/// @brief 获取负责 @a fd 且支持完成通知 IO 的 poller
+	/// @return 未使用 io_uring 时返回 nullptr
+	IoUringPoller* GetCompletionPoller(int fd) const;
+
+	/// @brief 定时器加入当前调度线程自身的 TimerManager，非调度线程共用一个 TimerManager
+	/// @param non_blocking  @a cb 不会阻塞或挂起，到期后直接在处理该定时器的 poller 线程上执行，
+	///		   否则作为任务提交，同一次到期的任务一并提交
+	///		   非阻塞回调运行于调度线程的空闲协程中，须短小，不得调用会挂起协程的接口(如 hook 的 IO、sleep)；
+	///		   其抛出的异常被捕获并记录日志，不影响同批的其他定时器
+	Timer::TimerId RunAt(std::chrono::steady_clock::time_point tp, std::function<void()> cb, bool non_blocking = false);
+	Timer::TimerId RunAtIf(std::chrono::steady_clock::time_point tp, std::weak_ptr<void> cond, std::function<void()> cb, bool non_blocking = false);
+	bool HasTimer(Timer::TimerId timer_id);
+	Timer::TimerId RunAfter(std::chrono::steady_clock::duration dur, std::function<void()> cb, bool repeated = false, bool non_blocking = false);
+	Timer::TimerId RunAfterIf(std::chrono::steady_clock::duration dur, std::weak_ptr<void> cond, std::function<void()> cb, bool repeated = false, bool non_blocking = false);
 
-	void CancelTimer(uint32_t timer_id);
+	/// @brief 每隔 @a interval 执行一次 @a cb，首次于 now + interval
+	///
+	///		   RunAfter 的重复定时器固定为 Timer::Repeat::kFixedDelay
+	/// @param repeat  错过周期时的处理方式，默认与首次到期时间保持对齐且不补发
+	Timer::TimerId RunEvery(std::chrono::steady_clock::duration interval, std::function<void()> cb
+			, Timer::Repeat repeat = Timer::Repeat::kFixedRateSkip, bool non_blocking = false);
+
+	/// @brief 由定时器所属的调度线程直接撤销，其他调度线程经无锁邮箱投递撤销请求
+	void CancelTimer(Timer::TimerId timer_id);
+
+	IdleStats GetIdleStats() const;
+
+	/// @brief 汇总所有 poller 每次等待返回的事件数分布
+	PollBatchStats GetPollBatchStats() const;
+
+	/// @brief 汇总所有 TimerManager 调用 timerfd_settime 的次数
+	uint64_t GetTimerFdSetCount() const;
 
 private:
-	void SchedulingFunc();
+	struct InvocableWrapper;
+	struct Worker;
+	struct TaskCache;
 
-	/// @brief 不加锁的向任务队列中添加任务
-	/// @return 若原队列为空，则返回 true ，用于判断是否需要通知其他线程有任务就绪
+	/// @brief 以 @a func 初始化一个任务节点，优先复用当前线程缓存的节点
 	template <typename Invocable>
-	bool AddTaskNoLock(Invocable&& func, pthread_t target_thread);
+	static InvocableWrapper* NewTask(Invocable&& func, pthread_t target_thread);
+
+	/// @brief 获取当前线程的任务节点缓存，若其已随线程退出而销毁，返回 nullptr
+	static TaskCache* GetThisThreadTaskCache();
+
+	/// @brief 从当前线程缓存的任务节点中取出一个，缓存为空时返回 nullptr
+	static InvocableWrapper* TakeCachedTask();
+
+	/// @brief 清空 @a task 并放入当前线程的缓存，缓存已满时释放
+	static void DeleteTask(InvocableWrapper* task);
+
+	/// @param worker_index  当前调度线程在 workers_ 中的下标
+	void SchedulingFunc(size_t worker_index);
+
+	/// @brief 提交任务
+	///
+	///		   - 指定了目标线程的任务放入目标线程的邮箱，并唤醒该线程
+	///		   - 由本调度器的调度线程提交的任务放入该线程自身的运行队列
+	///		   - 其他线程提交的任务放入全局注入队列 injectQueue_
+	void Submit(InvocableWrapper* task);
+
+	/// @brief 依次从自身运行队列、自身邮箱、全局注入队列以及其他调度线程的运行队列中获取任务
+	InvocableWrapper* TakeTask(Worker* worker);
+
+	InvocableWrapper* StealTask(Worker* thief);
+
+	/// @brief 以 Poller::TryPollAndHandle 忙轮询 @a poller，
+	///		   直至出现 @a worker 可以执行的任务，或连续 scheduler.busy_poll.idle_us 微秒无事可做
+	/// @return 是否等到了任务(或调度器已停止)，否则调用者应转为阻塞于 @a poller
+	bool BusyPoll(Worker* worker, Poller* poller);
+
+	/// @brief 唤醒阻塞于 @a poller 的线程，其正在忙轮询时无需唤醒
+	void NotifyPoller(Poller* poller);
+
+	/// @brief 是否存在尚未被获取的任务(包括所有线程的邮箱)
+	bool HasPendingTask() const;
+
+	/// @brief 是否存在 @a worker 可以执行的任务
+	bool HasRunnableTask(const Worker* worker) const;
+
+	/// @brief 获取当前线程对应的 Worker，若当前线程不是本调度器的调度线程，返回 nullptr
+	Worker* GetThisWorker() const;
+
+	/// @brief 获取运行于线程 @a pthread_id 的 Worker
+	Worker* FindWorker(::pthread_t pthread_id) const;
+
+	/// @brief 当前线程创建定时器所用的 TimerManager
+	TimerManager* GetLocalTimerManager() const;
+
+	/// @brief 获取 @a timer_id 所属的 TimerManager，标签无效时返回 nullptr
+	TimerManager* GetTimerManagerOf(Timer::TimerId timer_id) const;
+
+	/// @brief 获取负责 @a fd 的 poller
+	Poller* GetPollerOf(int fd) const;
+
+	/// @brief 获取负责定时器的 poller
+	Poller* GetPrimaryPoller() const
+	{ return pollers_.front().get(); }
 
-	void HandleIdle();
+	/// @brief 进入空闲前，按配置先自旋、再让出 CPU 以等待任务
+	///
+	///		   等待期间处于搜索状态，使任务提交者无需唤醒其他线程；
+	///		   处于搜索状态的线程数不超过调度线程数的一半
+	/// @return 是否等到了可执行的任务
+	bool SpinForTask(Worker* worker);
 
-	/// @brief 添加 num 个信号量
-	void Notify(uint64_t num = 1);
+	/// @brief 空闲时的处理
+	///
+	///		   同一时刻至多一个空闲线程(leader)阻塞于 poller，处理 IO 与定时器事件；
+	///		   其余空闲线程(follower)阻塞于各自的 Parker，以便被单独唤醒。
+	///		   multi-reactor 模式下，每个空闲线程均阻塞于自身的 poller
+	void HandleIdle(Worker* worker);
 
-	struct InvocableWrapper {
+	/// @brief 确保有 @a num 个调度线程去获取新提交的任务
+	///
+	///		   - 处于搜索状态的线程会获取任务，不必为其唤醒其他线程
+	///		   - 其余的由 follower 承担，follower 不足时唤醒 leader
+	void Notify(size_t num = 1);
+
+	/// @brief 将 @a worker 加入阻塞集合
+	void MarkParked(Worker* worker);
+
+	/// @brief 将 @a worker 移出阻塞集合
+	/// @return 是否由本次调用移出，即是否获得了唤醒该 worker 的权利
+	bool ClaimParked(Worker* worker);
+
+	/// @brief 唤醒已被移出阻塞集合的 @a worker，使其处于搜索状态
+	void Unpark(Worker* worker);
+
+	/// @brief 唤醒阻塞集合中的任意一个 follower
+	/// @return 是否存在这样的 follower
+	bool UnparkOne();
+
+	/// @brief 结束 @a worker 的搜索状态
+	/// @param found_task  是否找到了任务
+	void StopSearching(Worker* worker, bool found_task);
+
+	/// @brief 唤醒 @a worker，若其并未空闲则无操作
+	void Wake(Worker* worker);
+
+	/// @brief 逐个唤醒所有空闲的调度线程
+	void WakeAll();
+
+	struct InvocableWrapper : public MpscQueueHook {
 		InvocableWrapper() : target_thread(0), callback(nullptr), coroutine(nullptr) {}
 		explicit InvocableWrapper(const std::shared_ptr<concurrency::Coroutine>& co, ::pthread_t pthread_id = 0);
 		explicit InvocableWrapper(std::shared_ptr<concurrency::Coroutine>&& co, ::pthread_t pthread_id = 0);
@@ -84,38 +241,115 @@ private:
 		std::shared_ptr<concurrency::Coroutine> coroutine;
 	};
 
+	/// @brief 调度线程的上下文
+	struct Worker {
+		enum class IdleState : uint8_t {
+			kBusy,
+			kParked,	///< 阻塞于自身的 Parker
+			kPolling	///< 阻塞于 poller
+		};
+
+		explicit Worker(size_t idx) : index(idx) {}
+
+		const size_t index;
+		/// @brief 运行该 Worker 的线程，在其开始调度前设置
+		std::atomic<::pthread_t> pthread_id {INVALID_PTHREAD_ID};
+		std::atomic<IdleState> idle_state {IdleState::kBusy};
+		/// @brief 被唤醒后、获取到任务或再次空闲前处于搜索状态
+		std::atomic<bool> searching {false};
+		/// @brief 仅由所属调度线程压入/弹出，其他调度线程可从中窃取
+		WorkStealingDeque<InvocableWrapper> run_queue;
+		/// @brief 指定由该线程执行的任务，仅由所属调度线程取出
+		MpscQueue<InvocableWrapper> mailbox;
+		Parker parker;
+		/// @brief multi-reactor 模式下该线程所属的 poller，空闲时阻塞于此而非 parker
+		Poller* poller = nullptr;
+		/// @brief 该线程创建的定时器所在的 TimerManager，其标签为 index + 1
+		TimerManager* timer_manager = nullptr;
+
+		/// @brief 空闲策略的统计，仅由所属调度线程累加
+		std::atomic<uint64_t> spin_hits {0};
+		std::atomic<uint64_t> yield_hits {0};
+		std::atomic<uint64_t> spin_misses {0};
+		std::atomic<uint64_t> parks {0};
+		std::atomic<uint64_t> polls {0};
+		std::atomic<uint64_t> busy_poll_hits {0};
+		std::atomic<uint64_t> busy_poll_misses {0};
+		/// @brief 由唤醒者累加
+		std::atomic<uint64_t> unparks {0};
+	};
+
 private:
     std::string name_;
     std::shared_ptr<concurrency::Coroutine> dummyMainCoroutine_;
 	::pthread_t dummyMainTrdPthreadId_;
-	std::unique_ptr<concurrency::EpollPoller> poller_;
+	const bool multiReactor_;
+	/// @brief 首个 poller 同时负责定时器；multi-reactor 模式下第 i 个 poller 属于第 i 个 Worker
+	std::vector<std::unique_ptr<concurrency::Poller>> pollers_;
+	/// @brief 以标签为下标；标签 0 为首个 poller 的 TimerManager，供非调度线程使用
+	std::vector<TimerManager*> timerManagers_;
+	/// @brief 参与 fd 分配的 poller 数量，不包括 dummy-main 线程的 poller
+	size_t shardNum_ = 1;
     std::vector<std::unique_ptr<concurrency::Thread>> threadPool_;
 	std::atomic<bool> stopped_ {true};
 	std::atomic<size_t> activeThreadNum_ {0};
 	std::atomic<size_t> idleThreadNum_ {0};
-	std::list<Scheduler::InvocableWrapper> taskList_;
+	std::vector<std::unique_ptr<Worker>> workers_;
+	/// @brief 非调度线程提交的任务
+	std::deque<InvocableWrapper*> injectQueue_;
+	std::atomic<size_t> injectQueueSize_ {0};
+	/// @brief 是否已有空闲线程阻塞于 poller
+	std::atomic<bool> hasPollingLeader_ {false};
+	/// @brief 阻塞于 Parker 的 follower 集合，每个 Worker 占据一位
+	std::unique_ptr<std::atomic<uint64_t>[]> parkedMask_;
+	size_t parkedMaskWords_;
+	/// @brief 处于搜索状态的线程数量
+	std::atomic<size_t> searchingThreadNum_ {0};
+	mutable std::mutex injectMutex_;
 	mutable std::mutex mutex_;
 };
 
+/// @brief 待批量提交的任务
+class Scheduler::TaskBatch {
+public:
+	TaskBatch() = default;
+
+	~TaskBatch() noexcept;
+
+	/// @param target_thread  为当前任务指定一个特定线程执行，若为0则不指定
+	template <typename Invocable>
+	void Add(Invocable&& func, pthread_t target_thread = 0)
+	{ tasks_.push_back(NewTask(std::forward<Invocable>(func), target_thread)); }
+
+	size_t Size() const
+	{ return tasks_.size(); }
+
+	bool Empty() const
+	{ return tasks_.empty(); }
+
+private:
+	TaskBatch(const TaskBatch&) = delete;
+	TaskBatch& operator=(const TaskBatch&) = delete;
+
+	friend class Scheduler;
+
+private:
+	std::vector<InvocableWrapper*> tasks_;
+};
+
 template<typename Invocable>
 void Scheduler::Co(Invocable&& func, pthread_t target_thread) {
-	std::lock_guard<std::mutex> guard(mutex_);
-	bool need_notify = AddTaskNoLock(std::forward<Invocable>(func), target_thread);
-	if (need_notify) {
-		Notify();
-	}
+	Submit(NewTask(std::forward<Invocable>(func), target_thread));
 }
 
-template<typename Invocable>
-bool Scheduler::AddTaskNoLock(Invocable&& func, pthread_t target_thread) {
-	bool need_notify = false;
-	if (taskList_.empty()) {
-		need_notify = true;
+template <typename Invocable>
+Scheduler::InvocableWrapper* Scheduler::NewTask(Invocable&& func, pthread_t target_thread) {
+	InvocableWrapper* task = TakeCachedTask();
+	if (!task) {
+		return new InvocableWrapper(std::forward<Invocable>(func), target_thread);
 	}
-
-	taskList_.emplace_back(std::forward<Invocable>(func), target_thread);
-
-	return need_notify;
+	*task = InvocableWrapper(std::forward<Invocable>(func), target_thread);
+	return task;
 }
 
 } // namespace concurrency
@@ -0,0 +1,352 @@
+#include <concurrency/stack_pool.h>
+#include <base/config.h>
+#include <base/debug.h>
+
+#include <set>
+#include <mutex>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+#include <unistd.h>
+#include <cxxabi.h>
+#include <sys/mman.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto sys_logger = SYLAR_SYS_LOGGER();
+
+namespace {
+
+static std::atomic<size_t> s_stack_pool_watermark {16};
+static std::atomic<size_t> s_stack_pool_max_cached {128};
+static std::atomic<size_t> s_stack_usage_sample_period {64};
+
+struct __InitStackPoolConfigHelper {
+	__InitStackPoolConfigHelper() {
+		auto& config = base::Singleton<base::ConfigManager>::GetInstance();
+
+		auto watermark = config.AddOrUpdate<size_t>("coroutine.stack_pool.watermark",
+				s_stack_pool_watermark.load(), "cached stacks per size class beyond which returned stacks are MADV_DONTNEED");
+		watermark->AddMonitor([](const size_t&, const size_t& now) {
+			s_stack_pool_watermark.store(now, std::memory_order::memory_order_relaxed);
+		});
+
+		auto max_cached = config.AddOrUpdate<size_t>("coroutine.stack_pool.max_cached",
+				s_stack_pool_max_cached.load(), "max cached stacks per size class, the rest are unmapped");
+		max_cached->AddMonitor([](const size_t&, const size_t& now) {
+			s_stack_pool_max_cached.store(now, std::memory_order::memory_order_relaxed);
+		});
+
+		auto sample_period = config.AddOrUpdate<size_t>("coroutine.stack_usage.sample_period",
+				s_stack_usage_sample_period.load(), "sample the stack high-water mark of one in every N coroutine runs per thread, 0 disables sampling");
+		sample_period->AddMonitor([](const size_t&, const size_t& now) {
+			s_stack_usage_sample_period.store(now, std::memory_order::memory_order_relaxed);
+		});
+	}
+};
+
+static __InitStackPoolConfigHelper s_init_stack_pool_config_helper {};
+
+static void MergeUsage(cc::StackUsage* into, const cc::StackUsage& from) {
+	into->samples += from.samples;
+	into->total_used += from.total_used;
+	into->max_used = std::max(into->max_used, from.max_used);
+	into->stack_size = from.stack_size;
+}
+
+/// @brief 单个线程的栈使用统计，键为调用点(回调函数类型)的 mangled name
+///
+///		   采样只写入所在线程的统计，其锁仅与 GetUsageStats 竞争
+struct ThreadUsageStats {
+	ThreadUsageStats();
+	~ThreadUsageStats() noexcept;
+
+	std::mutex mutex;
+	std::unordered_map<const char*, cc::StackUsage> stats;
+	/// @brief 距上一次采样的使用次数
+	size_t runs = 0;
+};
+
+/// @brief 存活线程的统计，以及已退出线程合并后的统计
+static std::mutex s_usage_registry_mutex;
+static std::set<ThreadUsageStats*> s_usage_registry;
+static std::map<std::string, cc::StackUsage> s_retired_usage_stats;
+
+/// @brief 当前线程的统计是否已被销毁
+thread_local static bool tl_usage_stats_destroyed = false;
+
+ThreadUsageStats::ThreadUsageStats() {
+	std::lock_guard<std::mutex> guard(s_usage_registry_mutex);
+	s_usage_registry.insert(this);
+}
+
+ThreadUsageStats::~ThreadUsageStats() noexcept {
+	std::lock_guard<std::mutex> guard(s_usage_registry_mutex);
+	s_usage_registry.erase(this);
+	for (const auto& pair : stats) {
+		MergeUsage(&s_retired_usage_stats[pair.first], pair.second);
+	}
+	tl_usage_stats_destroyed = true;
+}
+
+/// @brief 获取当前线程的统计，若其已随线程退出而销毁，返回 nullptr
+static ThreadUsageStats* GetThisThreadUsageStats() {
+	if (__builtin_expect(tl_usage_stats_destroyed, 0)) {
+		return nullptr;
+	}
+	thread_local static ThreadUsageStats tl_usage_stats;
+	return &tl_usage_stats;
+}
+
+/// @brief 当前线程的栈池是否已被销毁
+thread_local static bool tl_stack_pool_destroyed = false;
+
+static size_t GetPageSize() {
+	static const size_t s_page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+	return s_page_size;
+}
+
+/// @brief 将 @a size 向上取整至 2 的幂次(不小于一页)，并返回其所属类别
+static size_t SizeClassOf(size_t size, size_t* rounded) {
+	size_t cls = 0;
+	size_t cur = GetPageSize();
+	while (cur < size) {
+		cur <<= 1;
+		++cls;
+	}
+	*rounded = cur;
+	return cls;
+}
+
+} // namespace
+
+cc::StackPool* cc::StackPool::GetThisThreadPool() {
+	if (__builtin_expect(tl_stack_pool_destroyed, 0)) {
+		return nullptr;
+	}
+	thread_local static StackPool tl_stack_pool;
+	return &tl_stack_pool;
+}
+
+cc::Stack cc::StackPool::Allocate(size_t size) {
+	StackPool* pool = GetThisThreadPool();
+	if (pool) {
+		return pool->Take(size);
+	}
+
+	size_t rounded = 0;
+	SizeClassOf(size, &rounded);
+	return Map(rounded);
+}
+
+void cc::StackPool::Deallocate(Stack stack) {
+	if (!stack) {
+		return;
+	}
+
+	// 协程可能在非创建线程上被析构，此时直接归还至析构线程的栈池
+	StackPool* pool = GetThisThreadPool();
+	if (pool) {
+		pool->Give(stack);
+	} else {
+		Unmap(stack);
+	}
+}
+
+bool cc::StackPool::BeginUsageSample(const Stack& stack) {
+	const size_t period = s_stack_usage_sample_period.load(std::memory_order::memory_order_relaxed);
+	ThreadUsageStats* usage_stats = GetThisThreadUsageStats();
+	if (!stack || period == 0 || !usage_stats || ++usage_stats->runs < period) {
+		return false;
+	}
+	usage_stats->runs = 0;
+
+	// 复用的栈仍驻留着先前使用者提交的页
+	if (::madvise(stack.base, stack.size, MADV_DONTNEED) < 0) {
+		SYLAR_LOG_WARN(sys_logger) << "failed to invoke ::madvise on coroutine stack"
+				<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void cc::StackPool::EndUsageSample(const Stack& stack, const char* callsite) {
+	SYLAR_ASSERT(callsite != nullptr);
+	const size_t used = MeasureHighWaterMark(stack);
+	StackUsage sample;
+	sample.samples = 1;
+	sample.max_used = used;
+	sample.total_used = used;
+	sample.stack_size = stack.size;
+
+	ThreadUsageStats* usage_stats = GetThisThreadUsageStats();
+	if (usage_stats) {
+		std::lock_guard<std::mutex> guard(usage_stats->mutex);
+		MergeUsage(&usage_stats->stats[callsite], sample);
+	} else {
+		// 线程退出时回收器中的协程晚于统计析构
+		std::lock_guard<std::mutex> guard(s_usage_registry_mutex);
+		MergeUsage(&s_retired_usage_stats[callsite], sample);
+	}
+}
+
+size_t cc::StackPool::MeasureHighWaterMark(const Stack& stack) {
+	const size_t page_size = GetPageSize();
+	const size_t page_num = stack.size / page_size;
+
+	// 线程退出时回收器中的协程可能晚于其他 thread_local 对象析构，因此只使用栈上的缓冲区
+	constexpr size_t kChunkPages = 256;
+	unsigned char residency[kChunkPages];
+
+	// 栈自高地址向低地址增长，最低的已提交页即为高水位
+	for (size_t begin = 0; begin < page_num; begin += kChunkPages) {
+		size_t count = std::min(kChunkPages, page_num - begin);
+		if (::mincore(static_cast<char*>(stack.base) + begin * page_size, count * page_size, residency) < 0) {
+			SYLAR_LOG_WARN(sys_logger) << "failed to invoke ::mincore on coroutine stack"
+					<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+			return 0;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			if (residency[i] & 1) {
+				return (page_num - begin - i) * page_size;
+			}
+		}
+	}
+	return 0;
+}
+
+std::map<std::string, cc::StackUsage> cc::StackPool::GetUsageStats() {
+	std::map<std::string, StackUsage> stats;
+	{
+		std::lock_guard<std::mutex> guard(s_usage_registry_mutex);
+		stats = s_retired_usage_stats;
+		for (ThreadUsageStats* usage_stats : s_usage_registry) {
+			std::lock_guard<std::mutex> stats_guard(usage_stats->mutex);
+			for (const auto& pair : usage_stats->stats) {
+				MergeUsage(&stats[pair.first], pair.second);
+			}
+		}
+	}
+
+	std::map<std::string, StackUsage> result;
+	for (auto& pair : stats) {
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(pair.first.c_str(), nullptr, nullptr, &status);
+		result[status == 0 && demangled ? demangled : pair.first] = pair.second;
+		::free(demangled);
+	}
+	return result;
+}
+
+std::string cc::StackPool::DumpUsageStats() {
+	std::ostringstream oss;
+	for (const auto& pair : GetUsageStats()) {
+		const StackUsage& usage = pair.second;
+		oss << pair.first
+			<< ": samples=" << usage.samples
+			<< ", max=" << usage.max_used
+			<< ", avg=" << (usage.samples ? usage.total_used / usage.samples : 0)
+			<< ", stack_size=" << usage.stack_size
+			<< std::endl;
+	}
+	return oss.str();
+}
+
+cc::StackPool::~StackPool() noexcept {
+	for (auto& free_list : freeLists_) {
+		for (const auto& stack : free_list) {
+			Unmap(stack);
+		}
+		free_list.clear();
+	}
+	tl_stack_pool_destroyed = true;
+}
+
+size_t cc::StackPool::GetCachedCount() const {
+	size_t count = 0;
+	for (const auto& free_list : freeLists_) {
+		count += free_list.size();
+	}
+	return count;
+}
+
+cc::Stack cc::StackPool::Take(size_t size) {
+	size_t rounded = 0;
+	size_t cls = SizeClassOf(size, &rounded);
+	if (cls >= kClassNum) {
+		return Map(rounded);
+	}
+
+	auto& free_list = freeLists_[cls];
+	if (free_list.empty()) {
+		return Map(rounded);
+	}
+
+	Stack stack = free_list.back();
+	free_list.pop_back();
+	return stack;
+}
+
+void cc::StackPool::Give(Stack stack) {
+	size_t rounded = 0;
+	size_t cls = SizeClassOf(stack.size, &rounded);
+	SYLAR_ASSERT(rounded == stack.size);
+
+	if (cls >= kClassNum) {
+		Unmap(stack);
+		return;
+	}
+
+	auto& free_list = freeLists_[cls];
+	if (free_list.size() >= s_stack_pool_max_cached.load(std::memory_order::memory_order_relaxed)) {
+		Unmap(stack);
+		return;
+	}
+
+	if (free_list.size() >= s_stack_pool_watermark.load(std::memory_order::memory_order_relaxed)) {
+		// 保留虚拟地址空间，仅归还物理页
+		if (::madvise(stack.base, stack.size, MADV_DONTNEED) < 0) {
+			SYLAR_LOG_WARN(sys_logger) << "failed to invoke ::madvise on coroutine stack"
+					<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+		}
+	}
+
+	free_list.push_back(stack);
+}
+
+cc::Stack cc::StackPool::Map(size_t size) {
+	const size_t page_size = GetPageSize();
+	const size_t map_size = size + page_size;
+
+	// 仅预留地址空间，物理页按需提交
+	void* addr = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0);
+	if (addr == MAP_FAILED) {
+		SYLAR_LOG_FATAL(sys_logger) << "failed to mmap coroutine stack, size=" << map_size
+				<< ", errno=" << errno << ", errstr: " << std::strerror(errno)
+				<< ", about to abort!" << std::endl;
+		std::abort();
+	}
+
+	// 栈向低地址增长，保护页位于最低处
+	if (::mprotect(addr, page_size, PROT_NONE) < 0) {
+		SYLAR_LOG_ERROR(sys_logger) << "failed to set the guard page of coroutine stack"
+				<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+	}
+
+	Stack stack;
+	stack.base = static_cast<char*>(addr) + page_size;
+	stack.size = size;
+	return stack;
+}
+
+void cc::StackPool::Unmap(Stack stack) {
+	const size_t page_size = GetPageSize();
+	if (::munmap(static_cast<char*>(stack.base) - page_size, stack.size + page_size) < 0) {
+		SYLAR_LOG_ERROR(sys_logger) << "failed to munmap coroutine stack"
+				<< ", errno=" << errno << ", errstr: " << std::strerror(errno) << std::endl;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace sylar {
+namespace concurrency {
+
+/// @brief 一段可供协程使用的栈空间，其低地址处紧邻一个 PROT_NONE 的保护页
+struct Stack {
+	void* base = nullptr;	///< 可用栈空间的低地址(保护页之上)
+	size_t size = 0;		///< 可用栈空间大小
+
+	explicit operator bool() const
+	{ return base != nullptr; }
+};
+
+/// @brief 按调用点聚合的栈使用统计
+struct StackUsage {
+	size_t samples = 0;		///< 采样次数
+	size_t max_used = 0;	///< 最大栈使用量(高水位)
+	size_t total_used = 0;	///< 栈使用量之和，用于计算均值
+	size_t stack_size = 0;	///< 最近一次采样时的栈大小
+};
+
+/// @brief 线程局部的协程栈池
+///
+///		   - 按页对齐后的 2 的幂次划分尺寸类别，同类别的栈可以互相复用
+///		   - 每个栈都通过 mmap(MAP_NORESERVE) 预留，物理页在首次访问时才被提交，
+///		     因此 stack_size 仅决定可增长的上限
+///		   - 栈底设置保护页，栈溢出会直接触发 SIGSEGV
+///		   - 按 coroutine.stack_usage.sample_period 对栈的使用进行采样：采样开始时清除栈上
+///		     先前使用者留下的驻留页，结束时通过 mincore 测量高水位，并按调用点聚合统计
+///		   - 归还时，若该类别已缓存的栈数量超过水位线，则通过 MADV_DONTNEED 释放其物理页；
+///		     超过缓存上限时直接 munmap
+class StackPool final {
+public:
+	/// @brief 获取当前线程的栈池，若其已随线程退出而销毁，返回 nullptr
+	static StackPool* GetThisThreadPool();
+
+	/// @brief 从当前线程的栈池分配一个至少 @a size 字节的栈
+	static Stack Allocate(size_t size);
+
+	/// @brief 将栈归还至当前线程的栈池
+	static void Deallocate(Stack stack);
+
+	/// @brief 在 @a stack 开始被新的使用者使用前调用，按采样周期决定此次使用是否被采样
+	///
+	///		   若被采样，通过 MADV_DONTNEED 清除栈上已驻留的页，使高水位只反映此次使用
+	/// @return 是否被采样，为 true 时须在使用结束后调用 EndUsageSample
+	/// @pre @a stack 当前未被任何执行流使用
+	static bool BeginUsageSample(const Stack& stack);
+
+	/// @brief 测量 @a stack 的高水位，并计入当前线程上 @a callsite 的统计
+	static void EndUsageSample(const Stack& stack, const char* callsite);
+
+	/// @brief 测量栈的高水位，即自栈顶至最低的已提交页的字节数
+	/// @note 页粒度；未经 BeginUsageSample 清除的栈，其结果包含先前使用者的用量
+	static size_t MeasureHighWaterMark(const Stack& stack);
+
+	/// @brief 汇总各线程的统计，获取所有调用点的栈使用统计，键为调用点名称
+	static std::map<std::string, StackUsage> GetUsageStats();
+
+	/// @brief 以可读格式输出所有调用点的栈使用统计
+	static std::string DumpUsageStats();
+
+	~StackPool() noexcept;
+
+	size_t GetCachedCount() const;
+
+private:
+	StackPool() = default;
+	StackPool(const StackPool&) = delete;
+	StackPool& operator=(const StackPool&) = delete;
+
+	Stack Take(size_t size);
+	void Give(Stack stack);
+
+	static Stack Map(size_t size);
+	static void Unmap(Stack stack);
+
+private:
+	static constexpr size_t kClassNum = 32;
+
+	std::vector<Stack> freeLists_[kClassNum];
+};
+
+} // namespace concurrency
+} // namespace sylar
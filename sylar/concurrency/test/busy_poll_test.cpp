@@ -0,0 +1,107 @@
+#include <concurrency/scheduler.h>
+#include <base/config.h>
+#include <base/debug.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const int kRoundNum = 1000;
+/// @brief 每隔 kPauseInterval 次往返暂停一次，暂停时长超过忙轮询时长
+static const int kPauseInterval = 100;
+static const int kPauseMs = 10;
+
+static std::atomic<int> s_port {0};
+
+void Echo() {
+	int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	std::memset(&addr, 0, sizeof addr);
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	SYLAR_ASSERT(::bind(sock, (const sockaddr*)&addr, sizeof addr) == 0);
+	SYLAR_ASSERT(::listen(sock, 1) == 0);
+
+	socklen_t len = sizeof addr;
+	::getsockname(sock, (sockaddr*)&addr, &len);
+	s_port = ntohs(addr.sin_port);
+
+	int fd = ::accept(sock, nullptr, nullptr);
+	SYLAR_ASSERT(fd >= 0);
+	::close(sock);
+
+	char buffer[64];
+	while (true) {
+		ssize_t num = ::read(fd, buffer, sizeof buffer);
+		if (num <= 0) {
+			break;
+		}
+		SYLAR_ASSERT(::write(fd, buffer, static_cast<size_t>(num)) == num);
+	}
+	::close(fd);
+}
+
+/// @brief 未 hook 的线程与调度器中的协程往返 kRoundNum 次，期间不时暂停，
+///		   忙轮询超时后应转为阻塞，且之后的请求仍能被及时处理
+static void PingPong(uint64_t busy_poll_idle_us) {
+	base::Singleton<base::ConfigManager>::GetInstance()
+		.Find<uint64_t>("scheduler.busy_poll.idle_us")->SetVal(busy_poll_idle_us);
+
+	s_port = 0;
+	cc::Scheduler scheduler(1, false, "BusyPollScheduler");
+	scheduler.Start();
+	scheduler.Co(&Echo);
+	while (s_port == 0) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	std::memset(&addr, 0, sizeof addr);
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(static_cast<uint16_t>(s_port.load()));
+	SYLAR_ASSERT(::connect(fd, (const sockaddr*)&addr, sizeof addr) == 0);
+
+	std::chrono::steady_clock::duration cost {0};
+	char buffer[8] = "ping";
+	for (int i = 0; i < kRoundNum; ++i) {
+		if (i % kPauseInterval == 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(kPauseMs));
+		}
+		auto begin = std::chrono::steady_clock::now();
+		SYLAR_ASSERT(::write(fd, buffer, 4) == 4);
+		SYLAR_ASSERT(::read(fd, buffer, sizeof buffer) == 4);
+		cost += std::chrono::steady_clock::now() - begin;
+	}
+	::close(fd);
+
+	auto stats = scheduler.GetIdleStats();
+	scheduler.Stop();
+
+	SYLAR_LOG_FMT_INFO(logger, "busy_poll.idle_us=%lu: rtt %.1f us, polls=%lu, busy poll hits=%lu, misses=%lu\n",
+			busy_poll_idle_us, std::chrono::duration<double, std::micro>(cost).count() / kRoundNum,
+			stats.polls, stats.busy_poll_hits, stats.busy_poll_misses);
+	if (busy_poll_idle_us == 0) {
+		SYLAR_ASSERT(stats.busy_poll_hits == 0 && stats.busy_poll_misses == 0);
+	} else {
+		// 每次暂停都会使忙轮询超时并转为阻塞；单核上客户端与调度线程交替运行，不保证有命中
+		SYLAR_ASSERT(stats.busy_poll_misses >= kRoundNum / kPauseInterval);
+		SYLAR_ASSERT(stats.polls >= stats.busy_poll_misses);
+	}
+}
+
+int main() {
+	logger->SetLogLevel(base::LogLevel::kInfo);
+	PingPong(0);
+	PingPong(1000);
+}
@@ -0,0 +1,76 @@
+#include <concurrency/context.h>
+#include <base/log.h>
+
+#include <chrono>
+#include <vector>
+#include <ucontext.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const size_t kRounds = 1000000;
+static const size_t kStackSize = 64 * 1024;
+
+// ------------------------------------------------------------------------
+// 当前编译所选用的后端
+
+static cc::Context s_main_ctx;
+static cc::Context s_co_ctx;
+
+static void ContextEntry() {
+	while (true) {
+		cc::Context::Swap(&s_co_ctx, &s_main_ctx);
+	}
+}
+
+static double BenchContext() {
+	std::vector<char> stack(kStackSize);
+	s_main_ctx.InitWithCurrent();
+	s_co_ctx.Make(stack.data(), stack.size(), &ContextEntry);
+
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kRounds; ++i) {
+		cc::Context::Swap(&s_main_ctx, &s_co_ctx);
+	}
+	std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+	return 2 * kRounds / cost.count();
+}
+
+// ------------------------------------------------------------------------
+// 作为对照的 ucontext
+
+static ::ucontext_t s_main_uctx;
+static ::ucontext_t s_co_uctx;
+
+static void UcontextEntry() {
+	while (true) {
+		::swapcontext(&s_co_uctx, &s_main_uctx);
+	}
+}
+
+static double BenchUcontext() {
+	std::vector<char> stack(kStackSize);
+	::getcontext(&s_co_uctx);
+	s_co_uctx.uc_link = nullptr;
+	s_co_uctx.uc_stack.ss_sp = stack.data();
+	s_co_uctx.uc_stack.ss_size = stack.size();
+	::makecontext(&s_co_uctx, &UcontextEntry, 0);
+
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kRounds; ++i) {
+		::swapcontext(&s_main_uctx, &s_co_uctx);
+	}
+	std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+	return 2 * kRounds / cost.count();
+}
+
+int main() {
+	double ucontext_rate = BenchUcontext();
+	double backend_rate = BenchContext();
+
+	SYLAR_LOG_FMT_INFO(logger, "ucontext: %.0f switches/sec\n", ucontext_rate);
+	SYLAR_LOG_FMT_INFO(logger, "%s: %.0f switches/sec (x%.2f)\n",
+			cc::Context::BackendName(), backend_rate, backend_rate / ucontext_rate);
+}
@@ -0,0 +1,138 @@
+#include <concurrency/scheduler.h>
+#include <concurrency/stack_pool.h>
+#include <base/config.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <set>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <unistd.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const int kConcurrentNum = 8;
+
+static std::atomic<int> s_finished {0};
+static std::atomic<cc::Coroutine::CoroutineId> s_last_id {0};
+static std::shared_ptr<cc::Coroutine> s_held;
+static std::vector<cc::Coroutine::CoroutineId> s_round_ids;
+
+static cc::Coroutine::CoroutineId GetCurrentId() {
+	return cc::this_thread::GetCurrentRunningCoroutine()->GetId();
+}
+
+/// @brief 提交 @a func 并等待其执行完毕
+template <typename Func>
+static void RunAndWait(cc::Scheduler& scheduler, Func func, int num = 1) {
+	s_finished = 0;
+	for (int i = 0; i < num; ++i) {
+		scheduler.Co(func);
+	}
+	while (s_finished < num) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	// 等待协程被归还至回收池
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+/// @brief 多个协程同时存活，挂起期间其余的任务开始执行
+static void Concurrent() {
+	s_round_ids.push_back(GetCurrentId());
+	usleep(20 * 1000);
+	++s_finished;
+}
+
+/// @brief 调用点以回调函数的类型区分，因此使用各自的函数对象类型
+struct DeepStack {
+	void operator()() const {
+		char buffer[64 * 1024];
+		std::memset(buffer, 1, sizeof buffer);
+		__asm__ __volatile__("" : : "r"(buffer) : "memory");
+		s_last_id = GetCurrentId();
+		++s_finished;
+	}
+};
+
+struct ShallowStack {
+	void operator()() const {
+		s_last_id = GetCurrentId();
+		++s_finished;
+	}
+};
+
+/// @brief 已结束的回调协程被同一线程上后续的回调任务复用
+int main() {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kInfo);
+	auto& config = base::Singleton<base::ConfigManager>::GetInstance();
+	config.Find<size_t>("coroutine.recycle_cap")->SetVal(2);
+	config.Find<size_t>("coroutine.stack_usage.sample_period")->SetVal(1);
+
+	cc::Scheduler scheduler(1, false, "CoroutineRecycleScheduler");
+	scheduler.Start();
+
+	// 结束的协程被复用
+	RunAndWait(scheduler, []() {
+		s_last_id = GetCurrentId();
+		++s_finished;
+	});
+	const auto first_id = s_last_id.load();
+	RunAndWait(scheduler, []() {
+		s_last_id = GetCurrentId();
+		++s_finished;
+	});
+	SYLAR_ASSERT(s_last_id == first_id);
+
+	// 仍被引用的协程不被回收
+	RunAndWait(scheduler, []() {
+		s_held = cc::this_thread::GetCurrentRunningCoroutine();
+		++s_finished;
+	});
+	SYLAR_ASSERT(s_held->GetId() == first_id);
+	RunAndWait(scheduler, []() {
+		s_last_id = GetCurrentId();
+		++s_finished;
+	});
+	SYLAR_ASSERT(s_last_id != first_id);
+	s_held.reset();
+
+	// 回收池的容量受 coroutine.recycle_cap 限制
+	s_round_ids.clear();
+	RunAndWait(scheduler, &Concurrent, kConcurrentNum);
+	std::set<cc::Coroutine::CoroutineId> seen(s_round_ids.begin(), s_round_ids.end());
+	SYLAR_ASSERT(seen.size() == kConcurrentNum);
+	s_round_ids.clear();
+	RunAndWait(scheduler, &Concurrent, kConcurrentNum);
+	int reused = 0;
+	for (auto id : s_round_ids) {
+		reused += seen.count(id);
+	}
+	SYLAR_ASSERT(reused == 2);
+
+	// 复用的协程的栈使用量计入各自回调函数的调用点
+	RunAndWait(scheduler, DeepStack());
+	const auto deep_id = s_last_id.load();
+	RunAndWait(scheduler, ShallowStack());
+	SYLAR_ASSERT(s_last_id == deep_id);
+	scheduler.Stop();
+
+	size_t deep_max = 0;
+	size_t shallow_max = 0;
+	for (const auto& pair : cc::StackPool::GetUsageStats()) {
+		if (pair.first.find("DeepStack") != std::string::npos) {
+			deep_max = pair.second.max_used;
+		} else if (pair.first.find("ShallowStack") != std::string::npos) {
+			shallow_max = pair.second.max_used;
+		}
+	}
+	SYLAR_ASSERT(deep_max >= 64 * 1024);
+	SYLAR_ASSERT(shallow_max > 0 && shallow_max < 32 * 1024);
+
+	SYLAR_LOG_INFO(logger) << "coroutine recycle test passed, deep=" << deep_max
+			<< ", shallow=" << shallow_max << std::endl;
+}
@@ -0,0 +1,73 @@
+#include <concurrency/scheduler.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const int kPairNum = 256;
+static const int kRoundNum = 20;
+
+static std::atomic<int> s_fired {0};
+
+static void WaitFired(int expect) {
+	for (int i = 0; i < 2000 && s_fired < expect; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+/// @brief 每次注册的事件至多被处理一次: 撤销后不再触发，触发后需重新注册
+int main() {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kInfo);
+	cc::Scheduler scheduler(4, false, "EventScheduler");
+	scheduler.Start();
+
+	int pairs[kPairNum][2];
+	for (auto& pair : pairs) {
+		SYLAR_ASSERT(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, pair) == 0);
+	}
+
+	int expect = 0;
+	for (int round = 0; round < kRoundNum; ++round) {
+		// 奇数下标的事件在就绪前被撤销
+		for (int i = 0; i < kPairNum; ++i) {
+			scheduler.AppendEvent(pairs[i][0], EPOLLIN, []() {
+				++s_fired;
+			});
+		}
+		for (int i = 1; i < kPairNum; i += 2) {
+			scheduler.CancelEvent(pairs[i][0], EPOLLIN);
+		}
+		for (auto& pair : pairs) {
+			SYLAR_ASSERT(::write(pair[1], "x", 1) == 1);
+		}
+
+		expect += kPairNum / 2;
+		WaitFired(expect);
+		SYLAR_ASSERT(s_fired == expect);
+
+		// 数据仍未读取，但未重新注册的 fd 不应再次触发
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		SYLAR_ASSERT(s_fired == expect);
+
+		char buffer[8];
+		for (auto& pair : pairs) {
+			SYLAR_ASSERT(::read(pair[0], buffer, sizeof buffer) == 1);
+		}
+	}
+
+	scheduler.Stop();
+	for (auto& pair : pairs) {
+		::close(pair[0]);
+		::close(pair[1]);
+	}
+	SYLAR_LOG_INFO(logger) << "epoll event test passed, fired=" << s_fired << std::endl;
+}
@@ -11,7 +11,7 @@ namespace cc = sylar::concurrency;
 
 int sock;
 
-uint32_t timer_id = 0;
+cc::Timer::TimerId timer_id = 0;
 
 void DoConnect(cc::Scheduler* scheduler) {
 	sock = ::socket(AF_INET, SOCK_STREAM, 0);
@@ -0,0 +1,125 @@
+#include <concurrency/hook.h>
+#include <concurrency/scheduler.h>
+#include <concurrency/fd_manager.h>
+#ifdef SYLAR_IO_URING
+#include <concurrency/io_uring_poller.h>
+#endif
+#include <base/config.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <atomic>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static int s_stream[2];
+static int s_dgram[2];
+static std::atomic<bool> s_done {false};
+
+/// @brief 先于写入方挂起等待，单个调度线程下若阻塞了线程则写入方无法运行
+static void Reader() {
+	char head[4] {};
+	char body[8] {};
+	struct iovec iov[2] {{head, sizeof head}, {body, sizeof body}};
+	SYLAR_ASSERT(readv(s_stream[0], iov, 2) == 12);
+	SYLAR_ASSERT(std::memcmp(head, "head", 4) == 0 && std::memcmp(body, "body1234", 8) == 0);
+
+	char buf[16] {};
+	SYLAR_ASSERT(recv(s_stream[0], buf, sizeof buf, 0) == 4);
+	SYLAR_ASSERT(std::memcmp(buf, "send", 4) == 0);
+
+	struct iovec msg_iov {buf, sizeof buf};
+	struct msghdr msg {};
+	msg.msg_iov = &msg_iov;
+	msg.msg_iovlen = 1;
+	SYLAR_ASSERT(recvmsg(s_stream[0], &msg, 0) == 7);
+	SYLAR_ASSERT(std::memcmp(buf, "sendmsg", 7) == 0);
+
+	SYLAR_ASSERT(recvfrom(s_dgram[0], buf, sizeof buf, 0, nullptr, nullptr) == 6);
+	SYLAR_ASSERT(std::memcmp(buf, "sendto", 6) == 0);
+
+	// MSG_DONTWAIT 不挂起协程
+	SYLAR_ASSERT(recv(s_stream[0], buf, sizeof buf, MSG_DONTWAIT) == -1 && errno == EAGAIN);
+
+	// 等待超时
+	struct timeval tv {0, 50 * 1000};
+	SYLAR_ASSERT(setsockopt(s_stream[0], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv) == 0);
+	auto begin = std::chrono::steady_clock::now();
+	SYLAR_ASSERT(recv(s_stream[0], buf, sizeof buf, 0) == -1 && errno == ETIMEDOUT);
+	SYLAR_ASSERT(std::chrono::steady_clock::now() - begin >= std::chrono::milliseconds(50));
+
+	s_done = true;
+}
+
+static void Writer() {
+	usleep(20 * 1000);
+	char head[] = "head";
+	char body[] = "body1234";
+	struct iovec iov[2] {{head, 4}, {body, 8}};
+	SYLAR_ASSERT(writev(s_stream[1], iov, 2) == 12);
+
+	usleep(20 * 1000);
+	SYLAR_ASSERT(send(s_stream[1], "send", 4, 0) == 4);
+
+	usleep(20 * 1000);
+	char data[] = "sendmsg";
+	struct iovec msg_iov {data, 7};
+	struct msghdr msg {};
+	msg.msg_iov = &msg_iov;
+	msg.msg_iovlen = 1;
+	SYLAR_ASSERT(sendmsg(s_stream[1], &msg, 0) == 7);
+
+	usleep(20 * 1000);
+	SYLAR_ASSERT(sendto(s_dgram[1], "sendto", 6, 0, nullptr, 0) == 6);
+}
+
+static void Run(const std::string& poller) {
+	base::Singleton<base::ConfigManager>::GetInstance().Find<std::string>("scheduler.poller")->SetVal(poller);
+	s_done = false;
+
+	SYLAR_ASSERT(::socketpair(AF_UNIX, SOCK_STREAM, 0, s_stream) == 0);
+	SYLAR_ASSERT(::socketpair(AF_UNIX, SOCK_DGRAM, 0, s_dgram) == 0);
+	// socketpair 未被 hook，手动建立 fd 上下文
+	auto& fd_manager = base::Singleton<cc::FdManager>::GetInstance();
+	for (int fd : {s_stream[0], s_stream[1], s_dgram[0], s_dgram[1]}) {
+		fd_manager.CreateFdContext(fd);
+	}
+
+	cc::Scheduler scheduler(1, false, "HookIovScheduler");
+	scheduler.Co(&Reader);
+	scheduler.Co(&Writer);
+	scheduler.Start();
+
+	for (int i = 0; i < 5000 && !s_done; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	SYLAR_ASSERT(s_done);
+	scheduler.Stop();
+
+	for (int fd : {s_stream[0], s_stream[1], s_dgram[0], s_dgram[1]}) {
+		fd_manager.RemoveFd(fd);
+		::close(fd);
+	}
+	SYLAR_LOG_INFO(logger) << "poller=" << poller << " passed" << std::endl;
+}
+
+/// @brief 向量 IO 与消息 IO 在数据未就绪时挂起协程而非阻塞调度线程，并按 SO_RCVTIMEO 超时
+int main() {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kInfo);
+	Run("epoll");
+#ifdef SYLAR_IO_URING
+	if (cc::IoUringPoller::IsSupported()) {
+		Run("io_uring");
+	}
+#endif
+	SYLAR_LOG_INFO(logger) << "hook iov test passed" << std::endl;
+}
@@ -0,0 +1,75 @@
+#include <concurrency/scheduler.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+/// @brief 阻塞前的计算时长，远大于阻塞时长
+static const auto kBusyTime = std::chrono::milliseconds(50);
+static const auto kSleepTime = std::chrono::milliseconds(10);
+static const auto kRecvTimeout = std::chrono::milliseconds(20);
+
+static std::atomic<bool> s_done {false};
+
+static void BusyWait() {
+	auto deadline = std::chrono::steady_clock::now() + kBusyTime;
+	while (std::chrono::steady_clock::now() < deadline) {
+	}
+}
+
+/// @brief 任务运行一段时间后调用被 hook 的阻塞函数，其阻塞时长从调用时算起，而非从任务开始时
+static void SleepAfterBusy() {
+	BusyWait();
+	auto begin = std::chrono::steady_clock::now();
+	usleep(static_cast<useconds_t>(std::chrono::microseconds(kSleepTime).count()));
+	auto cost = std::chrono::steady_clock::now() - begin;
+	SYLAR_ASSERT_WITH_MSG(cost >= kSleepTime, "usleep returned before its timeout");
+
+	BusyWait();
+	struct ::timespec ts {0, static_cast<long>(std::chrono::nanoseconds(kSleepTime).count())};
+	begin = std::chrono::steady_clock::now();
+	nanosleep(&ts, nullptr);
+	cost = std::chrono::steady_clock::now() - begin;
+	SYLAR_ASSERT_WITH_MSG(cost >= kSleepTime, "nanosleep returned before its timeout");
+
+	int fds[2];
+	SYLAR_ASSERT(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	struct ::timeval tv {0, static_cast<suseconds_t>(std::chrono::microseconds(kRecvTimeout).count())};
+	SYLAR_ASSERT(setsockopt(fds[0], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv) == 0);
+	BusyWait();
+	char c;
+	begin = std::chrono::steady_clock::now();
+	SYLAR_ASSERT(recv(fds[0], &c, 1, 0) == -1 && errno == EAGAIN);
+	cost = std::chrono::steady_clock::now() - begin;
+	SYLAR_ASSERT_WITH_MSG(cost >= kRecvTimeout, "recv timed out before SO_RCVTIMEO");
+	close(fds[0]);
+	close(fds[1]);
+
+	s_done = true;
+}
+
+int main() {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kInfo);
+
+	cc::Scheduler scheduler(1, false, "HookSleepScheduler");
+	scheduler.Start();
+	scheduler.Co(&SleepAfterBusy);
+
+	for (int i = 0; i < 5000 && !s_done; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	SYLAR_ASSERT(s_done);
+	scheduler.Stop();
+
+	SYLAR_LOG_INFO(logger) << "hook sleep test passed" << std::endl;
+}
@@ -0,0 +1,111 @@
+#include <concurrency/scheduler.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+/// @brief 一个线程阻塞于 poller，其余 kFollowerNum 个阻塞于各自的 Parker
+static const size_t kThreadNum = 4;
+static const size_t kFollowerNum = kThreadNum - 1;
+static const int kRaceRoundNum = 20000;
+/// @brief 远小于 Parker 与 poller 的阻塞超时(5s)，超出即视为丢失了唤醒
+static const auto kWakeDeadline = std::chrono::milliseconds(1000);
+
+static std::atomic<int> s_ran {0};
+
+static void Task() {
+	++s_ran;
+}
+
+/// @brief 等待所有 follower 阻塞于 Parker
+static void WaitForParked(const cc::Scheduler& scheduler, uint64_t parks) {
+	while (scheduler.GetIdleStats().parks < parks + kFollowerNum) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+static bool WaitForRan(int expected) {
+	auto deadline = std::chrono::steady_clock::now() + kWakeDeadline;
+	while (s_ran < expected) {
+		if (std::chrono::steady_clock::now() > deadline) {
+			return false;
+		}
+		std::this_thread::yield();
+	}
+	return true;
+}
+
+/// @brief 提交一个任务只唤醒一个 follower
+static void TestUnparkOne() {
+	s_ran = 0;
+	cc::Scheduler scheduler(kThreadNum, false, "UnparkOneScheduler");
+	scheduler.Start();
+	WaitForParked(scheduler, 0);
+
+	auto before = scheduler.GetIdleStats();
+	scheduler.Co(&Task);
+	SYLAR_ASSERT(WaitForRan(1));
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	auto after = scheduler.GetIdleStats();
+	SYLAR_ASSERT(after.unparks - before.unparks == 1);
+	SYLAR_ASSERT(s_ran == 1);
+
+	scheduler.Stop();
+	SYLAR_LOG_INFO(logger) << "unpark one: parks=" << after.parks << ", unparks=" << after.unparks << std::endl;
+}
+
+/// @brief 任务完成后间隔不等的时长再提交下一个，使提交与线程进入阻塞的过程交错；
+///		   仅有一个 follower，执行完任务的它即是唯一可被唤醒的线程
+static void TestSubmitRacingPark() {
+	s_ran = 0;
+	cc::Scheduler scheduler(2, false, "SubmitRacingParkScheduler");
+	scheduler.Start();
+
+	for (int i = 0; i < kRaceRoundNum; ++i) {
+		for (volatile int j = 0; j < i % 1024; ++j) {
+		}
+		scheduler.Co(&Task);
+		SYLAR_ASSERT_WITH_MSG(WaitForRan(i + 1), "the submitted task missed its wakeup");
+	}
+
+	auto stats = scheduler.GetIdleStats();
+	scheduler.Stop();
+	SYLAR_LOG_INFO(logger) << "submit racing park: rounds=" << kRaceRoundNum << ", parks=" << stats.parks
+			<< ", unparks=" << stats.unparks << std::endl;
+}
+
+/// @brief Stop 唤醒所有阻塞的 follower，而非等待其超时
+static void TestStopWakesAll() {
+	cc::Scheduler scheduler(kThreadNum, false, "StopWakesAllScheduler");
+	scheduler.Start();
+	WaitForParked(scheduler, 0);
+
+	auto before = scheduler.GetIdleStats();
+	auto begin = std::chrono::steady_clock::now();
+	scheduler.Stop();
+	auto cost = std::chrono::steady_clock::now() - begin;
+	auto after = scheduler.GetIdleStats();
+	SYLAR_ASSERT(cost < kWakeDeadline);
+	SYLAR_ASSERT(after.unparks - before.unparks == kFollowerNum);
+
+	SYLAR_LOG_INFO(logger) << "stop wakes all: cost="
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(cost).count() << "ms" << std::endl;
+}
+
+int main() {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kInfo);
+
+	TestUnparkOne();
+	TestSubmitRacingPark();
+	TestStopWakesAll();
+
+	SYLAR_LOG_INFO(logger) << "idle park test passed" << std::endl;
+}
@@ -0,0 +1,130 @@
+#include <concurrency/scheduler.h>
+#include <concurrency/io_uring_poller.h>
+#include <base/config.h>
+#include <base/debug.h>
+
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static std::atomic<int> s_port {0};
+static std::atomic<bool> s_echoed {false};
+static std::atomic<bool> s_timed_out {false};
+static std::atomic<bool> s_server_done {false};
+static std::atomic<bool> s_callback_invoked {false};
+static std::atomic<bool> s_timer_expired {false};
+
+/// @brief 通过被 hook 的 accept/read/write 回显一次，再验证读超时
+void Server() {
+	int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	std::memset(&addr, 0, sizeof addr);
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	SYLAR_ASSERT(::bind(sock, (const sockaddr*)&addr, sizeof addr) == 0);
+	SYLAR_ASSERT(::listen(sock, 1) == 0);
+
+	socklen_t len = sizeof addr;
+	::getsockname(sock, (sockaddr*)&addr, &len);
+	s_port = ntohs(addr.sin_port);
+
+	int fd = ::accept(sock, nullptr, nullptr);
+	SYLAR_ASSERT(fd >= 0);
+
+	char buffer[16];
+	ssize_t num = ::read(fd, buffer, sizeof buffer);
+	SYLAR_ASSERT(num == 4);
+	SYLAR_ASSERT(::write(fd, buffer, static_cast<size_t>(num)) == num);
+
+	struct timeval tv {0, 50 * 1000};
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+	num = ::read(fd, buffer, sizeof buffer);
+	s_timed_out = num == -1 && errno == ETIMEDOUT;
+
+	::close(fd);
+	::close(sock);
+	s_server_done = true;
+}
+
+/// @brief 通过被 hook 的 connect/write/read 发起一次请求
+void Client() {
+	while (s_port == 0) {
+		usleep(1000);
+	}
+
+	int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	std::memset(&addr, 0, sizeof addr);
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(static_cast<uint16_t>(s_port.load()));
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	SYLAR_ASSERT(::connect(sock, (const sockaddr*)&addr, sizeof addr) == 0);
+
+	SYLAR_ASSERT(::write(sock, "ping", 4) == 4);
+	char buffer[16];
+	SYLAR_ASSERT(::read(sock, buffer, sizeof buffer) == 4);
+	s_echoed = std::memcmp(buffer, "ping", 4) == 0;
+
+	while (!s_server_done) {
+		usleep(1000);
+	}
+	::close(sock);
+}
+
+int main() {
+#ifdef SYLAR_IO_URING
+	if (!cc::IoUringPoller::IsSupported()) {
+		SYLAR_LOG_INFO(logger) << "io_uring is unsupported by the kernel, skip" << std::endl;
+		return 0;
+	}
+
+	base::Singleton<base::ConfigManager>::GetInstance()
+		.Find<std::string>("scheduler.poller")->SetVal("io_uring");
+
+	cc::Scheduler scheduler(2, false, "IoUringScheduler");
+	scheduler.Start();
+	SYLAR_ASSERT(scheduler.GetCompletionPoller(0) != nullptr);
+
+	scheduler.Co(&Server);
+	scheduler.Co(&Client);
+
+	// 就绪通知
+	int pair[2];
+	SYLAR_ASSERT(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+	scheduler.AppendEvent(pair[0], EPOLLIN, []() {
+		s_callback_invoked = true;
+	});
+	SYLAR_ASSERT(::write(pair[1], "x", 1) == 1);
+
+	scheduler.RunAfter(std::chrono::milliseconds(10), []() {
+		s_timer_expired = true;
+	});
+
+	for (int i = 0; i < 2000; ++i) {
+		if (s_server_done && s_echoed && s_callback_invoked && s_timer_expired) {
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	scheduler.Stop();
+	::close(pair[0]);
+	::close(pair[1]);
+
+	SYLAR_ASSERT(s_echoed);
+	SYLAR_ASSERT(s_timed_out);
+	SYLAR_ASSERT(s_callback_invoked);
+	SYLAR_ASSERT(s_timer_expired);
+	SYLAR_LOG_INFO(logger) << "io_uring poller test passed" << std::endl;
+#else
+	SYLAR_LOG_INFO(logger) << "built without io_uring, skip" << std::endl;
+#endif
+}
@@ -0,0 +1,116 @@
+#include <concurrency/scheduler.h>
+#include <base/config.h>
+#include <base/debug.h>
+
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const int kConnNum = 8;
+static const int kRoundNum = 200;
+
+static std::atomic<int> s_port {0};
+static std::atomic<int> s_closed {0};
+static std::atomic<bool> s_migrated {false};
+
+/// @brief 首次阻塞后，同一连接上的读操作应当总在其 fd 所属的线程上返回，
+///		   即执行线程至多从创建线程切换一次
+void Echo(int fd) {
+	char buffer[64];
+	::pthread_t cur_thread = INVALID_PTHREAD_ID;
+	int switch_num = 0;
+	while (true) {
+		ssize_t num = ::read(fd, buffer, sizeof buffer);
+		if (num <= 0) {
+			break;
+		}
+
+		if (cur_thread != base::GetPthreadId()) {
+			cur_thread = base::GetPthreadId();
+			if (++switch_num > 2) {
+				s_migrated = true;
+			}
+		}
+		SYLAR_ASSERT(::write(fd, buffer, static_cast<size_t>(num)) == num);
+	}
+	::close(fd);
+	++s_closed;
+}
+
+void Listen() {
+	int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	std::memset(&addr, 0, sizeof addr);
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	SYLAR_ASSERT(::bind(sock, (const sockaddr*)&addr, sizeof addr) == 0);
+	SYLAR_ASSERT(::listen(sock, kConnNum) == 0);
+
+	socklen_t len = sizeof addr;
+	::getsockname(sock, (sockaddr*)&addr, &len);
+	s_port = ntohs(addr.sin_port);
+
+	for (int i = 0; i < kConnNum; ++i) {
+		int fd = ::accept(sock, nullptr, nullptr);
+		SYLAR_ASSERT(fd >= 0);
+		cc::this_thread::GetScheduler()->Co(std::bind(&Echo, fd));
+	}
+	::close(sock);
+}
+
+int main() {
+	base::Singleton<base::ConfigManager>::GetInstance()
+		.Find<bool>("scheduler.multi_reactor")->SetVal(true);
+
+	cc::Scheduler scheduler(4, false, "MultiReactorScheduler");
+	SYLAR_ASSERT(scheduler.IsMultiReactor());
+	scheduler.Start();
+	scheduler.Co(&Listen);
+
+	while (s_port == 0) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	struct sockaddr_in addr;
+	std::memset(&addr, 0, sizeof addr);
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(static_cast<uint16_t>(s_port.load()));
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	int clients[kConnNum];
+	for (int i = 0; i < kConnNum; ++i) {
+		clients[i] = ::socket(AF_INET, SOCK_STREAM, 0);
+		SYLAR_ASSERT(::connect(clients[i], (const sockaddr*)&addr, sizeof addr) == 0);
+	}
+
+	for (int round = 0; round < kRoundNum; ++round) {
+		for (int i = 0; i < kConnNum; ++i) {
+			int msg = round * kConnNum + i;
+			SYLAR_ASSERT(::write(clients[i], &msg, sizeof msg) == sizeof msg);
+		}
+		for (int i = 0; i < kConnNum; ++i) {
+			int reply = -1;
+			SYLAR_ASSERT(::read(clients[i], &reply, sizeof reply) == sizeof reply);
+			SYLAR_ASSERT(reply == round * kConnNum + i);
+		}
+	}
+
+	for (int i = 0; i < kConnNum; ++i) {
+		::close(clients[i]);
+	}
+	while (s_closed < kConnNum) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	scheduler.Stop();
+
+	SYLAR_ASSERT(!s_migrated);
+	SYLAR_LOG_INFO(logger) << "multi reactor test passed" << std::endl;
+}
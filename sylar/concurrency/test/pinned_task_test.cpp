@@ -0,0 +1,45 @@
+#include <concurrency/scheduler.h>
+#include <base/debug.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const int kRootNum = 4;
+static const int kPinnedNum = 1000;
+
+static std::atomic<int> s_finished {0};
+
+void Pinned(::pthread_t target) {
+	SYLAR_ASSERT(base::GetPthreadId() == target);
+	++s_finished;
+}
+
+/// @brief 向当前线程提交大量指定线程的任务，它们只能由当前线程执行
+void Root() {
+	auto scheduler = cc::this_thread::GetScheduler();
+	::pthread_t self = base::GetPthreadId();
+	for (int i = 0; i < kPinnedNum; ++i) {
+		scheduler->Co(std::bind(&Pinned, self), self);
+	}
+}
+
+int main() {
+	cc::Scheduler scheduler(4, false, "PinnedScheduler");
+	scheduler.Start();
+
+	for (int i = 0; i < kRootNum; ++i) {
+		scheduler.Co(&Root);
+	}
+
+	while (s_finished < kRootNum * kPinnedNum) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	scheduler.Stop();
+
+	SYLAR_LOG_INFO(logger) << "pinned task test passed" << std::endl;
+}
@@ -0,0 +1,118 @@
+#include <concurrency/scheduler.h>
+#include <base/log.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const size_t kFdNum = 1024;
+static const size_t kRoundNum = 200;
+static const size_t kReadyFdNum = 4096;
+static const size_t kReadyRoundNum = 100;
+
+/// @brief 每个线程在各自的 fd 上反复注册并撤销读事件，考察事件表查找与同步的开销
+/// @return (注册 + 撤销)/sec
+static double BenchRegisterCancel(size_t thread_num) {
+	cc::Scheduler scheduler(1, false, "bench");
+
+	std::vector<std::vector<int>> fds(thread_num);
+	for (auto& fd_set : fds) {
+		for (size_t i = 0; i < kFdNum; ++i) {
+			fd_set.push_back(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+		}
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < thread_num; ++t) {
+		threads.emplace_back([&scheduler, &fd_set = fds[t]]() {
+			for (size_t round = 0; round < kRoundNum; ++round) {
+				for (int fd : fd_set) {
+					scheduler.AppendEvent(fd, EPOLLIN, []() {});
+					scheduler.CancelEvent(fd, EPOLLIN);
+				}
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+
+	for (auto& fd_set : fds) {
+		for (int fd : fd_set) {
+			::close(fd);
+		}
+	}
+	return thread_num * kFdNum * kRoundNum / cost.count();
+}
+
+static void DumpBatchStats(const cc::PollBatchStats& stats) {
+	std::string dump;
+	for (size_t i = 0; i < cc::PollBatchStats::kBucketNum; ++i) {
+		if (stats.buckets[i] != 0) {
+			dump += " [" + std::to_string(size_t(1) << i) + ",)=" + std::to_string(stats.buckets[i]);
+		}
+	}
+	SYLAR_LOG_FMT_WARN(logger, "batch sizes:%s, full batches=%lu\n", dump.c_str(), stats.full_batches);
+}
+
+/// @brief 大量 fd 持续就绪，每个回调处理后重新注册，考察单次 epoll_wait 的批量大小对吞吐的影响
+/// @return 处理的就绪事件/sec
+static double BenchReadyBurst() {
+	cc::Scheduler scheduler(1, false, "bench");
+	scheduler.Start();
+
+	std::vector<int> fds;
+	for (size_t i = 0; i < kReadyFdNum; ++i) {
+		int fd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+		fds.push_back(fd);
+	}
+
+	std::atomic<size_t> handled {0};
+	std::function<void(int)> rearm = [&](int fd) {
+		scheduler.AppendEvent(fd, EPOLLIN, [&, fd]() {
+			if (++handled < kReadyFdNum * kReadyRoundNum) {
+				rearm(fd);
+			}
+		});
+	};
+
+	auto begin = std::chrono::steady_clock::now();
+	for (int fd : fds) {
+		rearm(fd);
+	}
+	while (handled < kReadyFdNum * kReadyRoundNum) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+
+	DumpBatchStats(scheduler.GetPollBatchStats());
+	scheduler.Stop();
+	for (int fd : fds) {
+		::close(fd);
+	}
+	return handled / cost.count();
+}
+
+int main(int argc, char** argv) {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kWarn);
+	size_t thread_num = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 4;
+
+	for (size_t n = 1; n <= thread_num; n *= 2) {
+		SYLAR_LOG_FMT_WARN(logger, "threads=%zu register+cancel: %.0f ops/sec\n", n, BenchRegisterCancel(n));
+	}
+	SYLAR_LOG_FMT_WARN(logger, "fds=%zu ready burst: %.0f events/sec\n", kReadyFdNum, BenchReadyBurst());
+}
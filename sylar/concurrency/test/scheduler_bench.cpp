@@ -0,0 +1,127 @@
+#include <concurrency/scheduler.h>
+#include <base/config.h>
+#include <base/log.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const size_t kTaskNum = 200000;
+static const size_t kFanOut = 64;
+
+static std::atomic<size_t> s_done {0};
+
+static void Leaf() {
+	s_done.fetch_add(1, std::memory_order::memory_order_relaxed);
+}
+
+/// @brief 由调度线程内部派生任务，主要考察运行队列与窃取的开销
+static void Spawner(size_t remain) {
+	auto scheduler = cc::this_thread::GetScheduler();
+	for (size_t i = 0; i < kFanOut && remain > 0; ++i, --remain) {
+		scheduler->Co(&Leaf);
+	}
+	if (remain > 0) {
+		scheduler->Co(std::bind(&Spawner, remain));
+	}
+	Leaf();
+}
+
+static void WaitDone(size_t expect) {
+	while (s_done.load(std::memory_order::memory_order_relaxed) < expect) {
+		std::this_thread::yield();
+	}
+}
+
+static void DumpIdleStats(const char* name, const cc::Scheduler& scheduler) {
+	auto stats = scheduler.GetIdleStats();
+	SYLAR_LOG_FMT_INFO(logger, "%s idle: spin_hits=%lu, yield_hits=%lu, spin_misses=%lu, parks=%lu, unparks=%lu, polls=%lu\n",
+			name, stats.spin_hits, stats.yield_hits, stats.spin_misses, stats.parks, stats.unparks, stats.polls);
+}
+
+/// @return tasks/sec
+static double BenchExternal(size_t thread_num) {
+	s_done = 0;
+	cc::Scheduler scheduler(thread_num, false, "bench");
+	scheduler.Start();
+
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kTaskNum; ++i) {
+		scheduler.Co(&Leaf);
+	}
+	WaitDone(kTaskNum);
+	std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+	DumpIdleStats("external", scheduler);
+
+	scheduler.Stop();
+	return kTaskNum / cost.count();
+}
+
+/// @brief 以 kFanOut 为一批提交任务
+/// @return tasks/sec
+static double BenchExternalBatch(size_t thread_num) {
+	s_done = 0;
+	cc::Scheduler scheduler(thread_num, false, "bench");
+	scheduler.Start();
+
+	auto begin = std::chrono::steady_clock::now();
+	cc::Scheduler::TaskBatch batch;
+	for (size_t i = 0; i < kTaskNum; ++i) {
+		batch.Add(&Leaf);
+		if (batch.Size() == kFanOut) {
+			scheduler.Co(batch);
+		}
+	}
+	scheduler.Co(batch);
+	WaitDone(kTaskNum);
+	std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+	DumpIdleStats("batch", scheduler);
+
+	scheduler.Stop();
+	return kTaskNum / cost.count();
+}
+
+/// @return tasks/sec
+static double BenchInternal(size_t thread_num) {
+	s_done = 0;
+	cc::Scheduler scheduler(thread_num, false, "bench");
+	scheduler.Start();
+
+	const size_t per_root = kTaskNum / thread_num;
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < thread_num; ++i) {
+		scheduler.Co(std::bind(&Spawner, per_root - 1));
+	}
+	// 每个根任务至少产生 per_root 次计数
+	WaitDone(per_root * thread_num);
+	std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+	DumpIdleStats("internal", scheduler);
+
+	scheduler.Stop();
+	return s_done.load() / cost.count();
+}
+
+/// @brief usage: scheduler_bench [max_threads] [idle_spin_us]
+int main(int argc, char** argv) {
+	size_t max_threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+	logger->SetLogLevel(base::LogLevel::kInfo);
+
+	if (argc > 2) {
+		base::Singleton<base::ConfigManager>::GetInstance()
+			.Find<uint64_t>("scheduler.idle.spin_us")->SetVal(std::strtoull(argv[2], nullptr, 10));
+	}
+
+	for (size_t n = 1; n <= max_threads; n <<= 1) {
+		double external = BenchExternal(n);
+		double batch = BenchExternalBatch(n);
+		double internal = BenchInternal(n);
+		SYLAR_LOG_FMT_INFO(logger, "threads=%zu external: %.0f tasks/sec, batch: %.0f tasks/sec, internal: %.0f tasks/sec\n",
+				n, external, batch, internal);
+	}
+}
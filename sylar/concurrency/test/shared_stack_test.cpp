@@ -0,0 +1,52 @@
+#include <concurrency/scheduler.h>
+#include <base/config.h>
+#include <base/debug.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static std::atomic<int> s_finished {0};
+
+/// @brief 多个共享栈协程交替执行，各自栈上的数据应当保持不变
+void Task(int seed) {
+	int local[256];
+	for (int i = 0; i < 256; ++i) {
+		local[i] = seed * 1000 + i;
+	}
+
+	for (int round = 0; round < 3; ++round) {
+		auto cur = cc::this_thread::GetCurrentRunningCoroutine();
+		SYLAR_ASSERT(cur->IsSharedStack());
+		cur.reset();
+		cc::Coroutine::YieldCurCoroutineToReady();
+
+		for (int i = 0; i < 256; ++i) {
+			SYLAR_ASSERT(local[i] == seed * 1000 + i);
+		}
+	}
+
+	++s_finished;
+}
+
+int main() {
+	base::Singleton<base::ConfigManager>::GetInstance()
+		.Find<bool>("scheduler.shared_stack")->SetVal(true);
+
+	cc::Scheduler scheduler(2, false, "SharedStackScheduler");
+	for (int i = 0; i < 8; ++i) {
+		scheduler.Co(std::bind(&Task, i));
+	}
+	scheduler.Start();
+
+	while (s_finished < 8) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	scheduler.Stop();
+
+	SYLAR_LOG_INFO(logger) << "shared stack test passed" << std::endl;
+}
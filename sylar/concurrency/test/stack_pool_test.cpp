@@ -0,0 +1,76 @@
+#include <concurrency/stack_pool.h>
+#include <base/config.h>
+#include <base/debug.h>
+
+#include <thread>
+#include <cstring>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+int main() {
+	auto pool = cc::StackPool::GetThisThreadPool();
+	SYLAR_ASSERT(pool != nullptr);
+
+	// 尺寸向上取整至 2 的幂次
+	cc::Stack s1 = cc::StackPool::Allocate(100 * 1024);
+	SYLAR_ASSERT(s1.size == 128 * 1024);
+	std::memset(s1.base, 0xCC, s1.size);
+
+	// 同尺寸类别的栈被复用
+	void* base = s1.base;
+	cc::StackPool::Deallocate(s1);
+	SYLAR_ASSERT(pool->GetCachedCount() == 1);
+	cc::Stack s2 = cc::StackPool::Allocate(128 * 1024);
+	SYLAR_ASSERT(s2.base == base);
+	SYLAR_ASSERT(pool->GetCachedCount() == 0);
+	// 仅被访问过的页被提交，高水位以页为粒度
+	SYLAR_ASSERT(cc::StackPool::MeasureHighWaterMark(s2) == s2.size);
+	cc::Stack s3 = cc::StackPool::Allocate(1024 * 1024);
+	SYLAR_ASSERT(cc::StackPool::MeasureHighWaterMark(s3) == 0);
+	std::memset(static_cast<char*>(s3.base) + s3.size - 10000, 0, 10000);
+	SYLAR_ASSERT(cc::StackPool::MeasureHighWaterMark(s3) == 12 * 1024);
+
+	cc::StackPool::Deallocate(s3);
+
+	// 采样开始时清除先前使用者的驻留页，高水位只反映此次使用
+	base::Singleton<base::ConfigManager>::GetInstance()
+		.Find<size_t>("coroutine.stack_usage.sample_period")->SetVal(1);
+	SYLAR_ASSERT(cc::StackPool::MeasureHighWaterMark(s2) == s2.size);
+	SYLAR_ASSERT(cc::StackPool::BeginUsageSample(s2));
+	SYLAR_ASSERT(cc::StackPool::MeasureHighWaterMark(s2) == 0);
+	std::memset(static_cast<char*>(s2.base) + s2.size - 10000, 0, 10000);
+	cc::StackPool::EndUsageSample(s2, "stack_pool_test");
+
+	// 按周期采样
+	base::Singleton<base::ConfigManager>::GetInstance()
+		.Find<size_t>("coroutine.stack_usage.sample_period")->SetVal(4);
+	int sampled = 0;
+	for (int i = 0; i < 8; ++i) {
+		sampled += cc::StackPool::BeginUsageSample(s2);
+	}
+	SYLAR_ASSERT(sampled == 2);
+	cc::StackPool::Deallocate(s2);
+
+	// 已退出线程的统计被合并
+	std::thread([]() {
+		cc::Stack stack = cc::StackPool::Allocate(128 * 1024);
+		for (int i = 0; i < 4; ++i) {
+			if (cc::StackPool::BeginUsageSample(stack)) {
+				std::memset(static_cast<char*>(stack.base) + stack.size - 40000, 0, 40000);
+				cc::StackPool::EndUsageSample(stack, "stack_pool_test");
+			}
+		}
+		cc::StackPool::Deallocate(stack);
+	}).join();
+
+	const cc::StackUsage usage = cc::StackPool::GetUsageStats()["stack_pool_test"];
+	SYLAR_ASSERT(usage.samples == 2);
+	SYLAR_ASSERT(usage.max_used == 40 * 1024);
+	SYLAR_ASSERT(usage.total_used == 12 * 1024 + 40 * 1024);
+	SYLAR_LOG_INFO(logger) << "stack usage:\n" << cc::StackPool::DumpUsageStats();
+
+	SYLAR_LOG_INFO(logger) << "stack pool test passed, cached=" << pool->GetCachedCount() << std::endl;
+}
@@ -0,0 +1,75 @@
+#include <concurrency/scheduler.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+#include <new>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const int kChainLength = 10000;
+static const int kWarmUp = 1000;
+
+thread_local static bool tl_counting = false;
+static std::atomic<size_t> s_alloc_num {0};
+static std::atomic<bool> s_done {false};
+
+void* operator new(size_t size) {
+	if (tl_counting) {
+		s_alloc_num.fetch_add(1, std::memory_order::memory_order_relaxed);
+	}
+	void* p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	std::free(p);
+}
+
+/// @brief 每个任务提交下一个任务，捕获的数据位于 std::function 的内联缓冲区内
+struct Chain {
+	void operator()() const {
+		if (n == kWarmUp) {
+			tl_counting = true;
+		}
+		if (n == kChainLength) {
+			tl_counting = false;
+			s_done = true;
+			return;
+		}
+		cc::this_thread::GetScheduler()->Co(Chain {n + 1});
+	}
+
+	int n;
+};
+
+/// @brief 调度线程上稳态的 Co(callback) 不分配内存：任务节点、协程对象及其栈均被复用
+int main() {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kInfo);
+
+	cc::Scheduler scheduler(1, false, "TaskAllocScheduler");
+	scheduler.Start();
+	scheduler.Co(Chain {0});
+
+	for (int i = 0; i < 5000 && !s_done; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	SYLAR_ASSERT(s_done);
+	scheduler.Stop();
+
+	SYLAR_LOG_INFO(logger) << "allocations in " << kChainLength - kWarmUp << " tasks: " << s_alloc_num << std::endl;
+	SYLAR_ASSERT(s_alloc_num == 0);
+	SYLAR_LOG_INFO(logger) << "task alloc test passed" << std::endl;
+}
@@ -0,0 +1,125 @@
+#include <concurrency/scheduler.h>
+#include <base/config.h>
+#include <base/log.h>
+
+#include <deque>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const size_t kOpNum = 20000;
+
+/// @brief 在 @a live_num 个长期存在的定时器之上反复添加并撤销定时器，即 hook IO 等待超时的模式
+/// @return (添加 + 撤销)/sec
+static double BenchAddCancel(const std::string& backend, size_t live_num) {
+	base::Singleton<base::ConfigManager>::GetInstance()
+		.Find<std::string>("timer.backend")->SetVal(backend);
+	cc::Scheduler scheduler(1, false, "bench");
+
+	std::vector<cc::Timer::TimerId> live_ids;
+	for (size_t i = 0; i < live_num; ++i) {
+		// 早于反复添加的定时器，使按 id 的线性查找需扫描全部
+		live_ids.push_back(scheduler.RunAfter(std::chrono::seconds(30) + std::chrono::microseconds(i), []() {}));
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kOpNum; ++i) {
+		cc::Timer::TimerId id = scheduler.RunAfter(std::chrono::seconds(60) + std::chrono::microseconds(i % 1000), []() {});
+		scheduler.CancelTimer(id);
+	}
+	std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+
+	for (cc::Timer::TimerId id : live_ids) {
+		scheduler.CancelTimer(id);
+	}
+	return kOpNum / cost.count();
+}
+
+/// @brief 以 hook IO 超时的模式每 @a gap 添加一个超时各异的定时器，并撤销 @a window 次操作之前添加的定时器
+/// @return 平均每次添加所调用的 timerfd_settime 次数
+static double BenchTimeoutChurn(const std::string& backend, uint64_t slack_us, std::chrono::microseconds gap, size_t window) {
+	base::Singleton<base::ConfigManager>::GetInstance()
+		.Find<std::string>("timer.backend")->SetVal(backend);
+	base::Singleton<base::ConfigManager>::GetInstance()
+		.Find<uint64_t>("timer.slack_us")->SetVal(slack_us);
+	cc::Scheduler scheduler(1, false, "bench");
+	scheduler.Start();
+
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> timeout_us(5000, 15000);
+	std::deque<cc::Timer::TimerId> pending;
+	const uint64_t base_count = scheduler.GetTimerFdSetCount();
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kOpNum; ++i) {
+		while (std::chrono::steady_clock::now() < begin + gap * i) {
+		}
+		pending.push_back(scheduler.RunAfter(std::chrono::microseconds(timeout_us(rng)), []() {}));
+		if (pending.size() > window) {
+			scheduler.CancelTimer(pending.front());
+			pending.pop_front();
+		}
+	}
+	for (cc::Timer::TimerId id : pending) {
+		scheduler.CancelTimer(id);
+	}
+	const uint64_t count = scheduler.GetTimerFdSetCount() - base_count;
+
+	scheduler.Stop();
+	return static_cast<double>(count) / kOpNum;
+}
+
+/// @brief 添加 @a num 个同时到期的定时器，即大量 IO 同时超时
+/// @return 从到期到全部回调执行完毕的耗时(ms)
+static double BenchExpiry(bool non_blocking, int num) {
+	base::Singleton<base::ConfigManager>::GetInstance()
+		.Find<std::string>("timer.backend")->SetVal("wheel");
+	cc::Scheduler scheduler(2, false, "bench");
+	scheduler.Start();
+
+	std::atomic<int> fired {0};
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+	for (int i = 0; i < num; ++i) {
+		scheduler.RunAt(deadline, [&fired]() {
+			fired.fetch_add(1, std::memory_order::memory_order_relaxed);
+		}, non_blocking);
+	}
+	while (fired.load(std::memory_order::memory_order_relaxed) < num) {
+		std::this_thread::yield();
+	}
+	std::chrono::duration<double, std::milli> cost = std::chrono::steady_clock::now() - deadline;
+
+	scheduler.Stop();
+	return cost.count();
+}
+
+/// @brief usage: timer_bench [max_live_timers]
+int main(int argc, char** argv) {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kWarn);
+	size_t max_live = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+
+	for (size_t live = 100; live <= max_live; live *= 10) {
+		for (const char* backend : {"set", "wheel"}) {
+			SYLAR_LOG_FMT_WARN(logger, "backend=%s live=%zu add+cancel: %.0f ops/sec\n",
+					backend, live, BenchAddCancel(backend, live));
+		}
+	}
+
+	for (const char* backend : {"set", "wheel"}) {
+		for (uint64_t slack_us : {0, 100, 1000}) {
+			SYLAR_LOG_FMT_WARN(logger, "backend=%s slack=%luus timeout churn: %.3f timerfd_settime per timer\n",
+					backend, slack_us, BenchTimeoutChurn(backend, slack_us, std::chrono::microseconds(20), 8));
+		}
+	}
+
+	for (bool non_blocking : {false, true}) {
+		SYLAR_LOG_FMT_WARN(logger, "non_blocking=%d expiry of %d timers: %.2f ms\n",
+				non_blocking, 100000, BenchExpiry(non_blocking, 100000));
+	}
+}
@@ -0,0 +1,191 @@
+#include <concurrency/scheduler.h>
+#include <concurrency/timer_manager.h>
+#include <base/config.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <map>
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const int kRootNum = 16;
+static const int kTimerNum = 200;
+
+static std::atomic<int> s_fired {0};
+static std::atomic<int> s_cancelled {0};
+static std::atomic<int> s_roots {0};
+
+/// @brief 撤销其他线程的定时器期间的内存分配次数
+thread_local static bool tl_counting = false;
+static std::atomic<size_t> s_foreign_cancel_allocs {0};
+
+void* operator new(size_t size) {
+	if (tl_counting) {
+		s_foreign_cancel_allocs.fetch_add(1, std::memory_order::memory_order_relaxed);
+	}
+	void* p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	std::free(p);
+}
+
+static std::mutex s_mutex;
+static std::vector<cc::Timer::TimerId> s_ids;
+static std::map<::pthread_t, uint8_t> s_thread_tags;
+
+/// @brief 在调度线程上创建定时器，同一线程创建的定时器属于同一个 TimerManager
+static void Root() {
+	auto scheduler = cc::this_thread::GetScheduler();
+	std::vector<cc::Timer::TimerId> ids;
+	for (int i = 0; i < kTimerNum; ++i) {
+		ids.push_back(scheduler->RunAfter(std::chrono::milliseconds(500), []() {
+			++s_fired;
+		}));
+	}
+
+	std::lock_guard<std::mutex> guard(s_mutex);
+	const uint8_t tag = cc::Timer::GetIdTag(ids.front());
+	SYLAR_ASSERT(tag != 0);
+	for (auto id : ids) {
+		SYLAR_ASSERT(cc::Timer::GetIdTag(id) == tag);
+	}
+	auto it = s_thread_tags.emplace(base::GetPthreadId(), tag).first;
+	SYLAR_ASSERT(it->second == tag);
+	s_ids.insert(s_ids.end(), ids.begin(), ids.end());
+	++s_roots;
+}
+
+/// @brief 在任意调度线程上撤销定时器，其中大部分属于其他线程
+static void Cancel(std::vector<cc::Timer::TimerId> ids) {
+	auto scheduler = cc::this_thread::GetScheduler();
+	uint8_t self_tag = 0;
+	{
+		std::lock_guard<std::mutex> guard(s_mutex);
+		auto it = s_thread_tags.find(base::GetPthreadId());
+		if (it != s_thread_tags.end()) {
+			self_tag = it->second;
+		}
+	}
+	for (auto id : ids) {
+		// 投递至其他线程的撤销请求不分配内存
+		tl_counting = cc::Timer::GetIdTag(id) != self_tag;
+		scheduler->CancelTimer(id);
+		tl_counting = false;
+		++s_cancelled;
+	}
+}
+
+static void Run(bool multi_reactor) {
+	base::Singleton<base::ConfigManager>::GetInstance().Find<bool>("scheduler.multi_reactor")->SetVal(multi_reactor);
+	s_fired = 0;
+	s_cancelled = 0;
+	s_roots = 0;
+	s_ids.clear();
+	s_thread_tags.clear();
+
+	cc::Scheduler scheduler(4, false, "TimerCancelScheduler");
+	scheduler.Start();
+
+	for (int i = 0; i < kRootNum; ++i) {
+		scheduler.Co(&Root);
+	}
+	while (s_roots < kRootNum) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// 非调度线程创建的定时器属于共用的 TimerManager
+	cc::Timer::TimerId shared_id = scheduler.RunAfter(std::chrono::milliseconds(500), []() {
+		++s_fired;
+	});
+	SYLAR_ASSERT(cc::Timer::GetIdTag(shared_id) == 0);
+	scheduler.CancelTimer(shared_id);
+	SYLAR_ASSERT(!scheduler.HasTimer(shared_id));
+
+	// 偶数下标的定时器由调度线程撤销，下标模 4 余 1 的由当前线程撤销，其余的到期
+	std::vector<cc::Timer::TimerId> batch;
+	int expect_cancelled = 0;
+	for (size_t i = 0; i < s_ids.size(); ++i) {
+		if (i % 2 == 0) {
+			batch.push_back(s_ids[i]);
+			++expect_cancelled;
+		} else if (i % 4 == 1) {
+			scheduler.CancelTimer(s_ids[i]);
+			SYLAR_ASSERT(!scheduler.HasTimer(s_ids[i]));
+		}
+		if (batch.size() == 64 || (i + 1 == s_ids.size() && !batch.empty())) {
+			scheduler.Co(std::bind(&Cancel, std::move(batch)));
+			batch.clear();
+		}
+	}
+	while (s_cancelled < expect_cancelled) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	const int expect_fired = kRootNum * kTimerNum / 4;
+	for (int i = 0; i < 3000 && s_fired < expect_fired; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	SYLAR_ASSERT(s_fired == expect_fired);
+	SYLAR_ASSERT(s_foreign_cancel_allocs == 0);
+	for (auto id : s_ids) {
+		SYLAR_ASSERT(!scheduler.HasTimer(id));
+	}
+
+	scheduler.Stop();
+	SYLAR_LOG_INFO(logger) << "multi_reactor=" << multi_reactor
+			<< ", threads=" << s_thread_tags.size() << ", fired=" << s_fired << std::endl;
+}
+
+/// @brief 定时器到期后其槽位被复用，持有旧 id 的撤销与查找不影响新的定时器
+static void RunStaleId() {
+	base::Singleton<base::ConfigManager>::GetInstance().Find<bool>("scheduler.multi_reactor")->SetVal(false);
+	cc::Scheduler scheduler(1, false, "TimerStaleIdScheduler");
+	scheduler.Start();
+
+	std::atomic<bool> fired {false};
+	cc::Timer::TimerId stale_id = scheduler.RunAfter(std::chrono::milliseconds(1), [&fired]() {
+		fired = true;
+	});
+	while (!fired) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	cc::Timer::TimerId id = scheduler.RunAfter(std::chrono::seconds(60), []() {});
+	SYLAR_ASSERT(cc::Timer::GetIdSlot(id) == cc::Timer::GetIdSlot(stale_id));
+	SYLAR_ASSERT(id != stale_id);
+	SYLAR_ASSERT(!scheduler.HasTimer(stale_id));
+	scheduler.CancelTimer(stale_id);
+	SYLAR_ASSERT(scheduler.HasTimer(id));
+
+	scheduler.CancelTimer(id);
+	SYLAR_ASSERT(!scheduler.HasTimer(id));
+	scheduler.Stop();
+}
+
+/// @brief 每个调度线程的定时器位于各自的 TimerManager，其他线程的撤销经邮箱生效
+int main() {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kInfo);
+	Run(false);
+	Run(true);
+	RunStaleId();
+	SYLAR_LOG_INFO(logger) << "timer cancel test passed" << std::endl;
+}
@@ -0,0 +1,73 @@
+#include <concurrency/scheduler.h>
+#include <base/config.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const int kRootNum = 8;
+static const int kTimerNum = 500;
+
+static std::atomic<int> s_inline_fired {0};
+static std::atomic<int> s_task_fired {0};
+
+/// @brief multi-reactor 模式下定时器由创建线程的 poller 处理，非阻塞的回调即在创建线程上执行
+static void Root() {
+	auto scheduler = cc::this_thread::GetScheduler();
+	::pthread_t self = base::GetPthreadId();
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+	// 抛出异常的非阻塞回调不影响同批的其他定时器，也不终止空闲协程
+	scheduler->RunAt(deadline, []() {
+		throw std::runtime_error("non-blocking timer throws");
+	}, true);
+	for (int i = 0; i < kTimerNum; ++i) {
+		scheduler->RunAt(deadline, [self]() {
+			SYLAR_ASSERT(base::GetPthreadId() == self);
+			++s_inline_fired;
+		}, true);
+		scheduler->RunAt(deadline, []() {
+			++s_task_fired;
+		});
+	}
+}
+
+int main() {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kInfo);
+	base::Singleton<base::ConfigManager>::GetInstance().Find<bool>("scheduler.multi_reactor")->SetVal(true);
+
+	cc::Scheduler scheduler(4, false, "TimerDispatchScheduler");
+	scheduler.Start();
+	for (int i = 0; i < kRootNum; ++i) {
+		scheduler.Co(&Root);
+	}
+
+	const int expect = kRootNum * kTimerNum;
+	for (int i = 0; i < 2000 && (s_inline_fired < expect || s_task_fired < expect); ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	SYLAR_ASSERT(s_inline_fired == expect);
+	SYLAR_ASSERT(s_task_fired == expect);
+
+	// 空闲协程在异常后仍能继续处理定时器与任务
+	s_inline_fired = 0;
+	s_task_fired = 0;
+	for (int i = 0; i < kRootNum; ++i) {
+		scheduler.Co(&Root);
+	}
+	for (int i = 0; i < 2000 && (s_inline_fired < expect || s_task_fired < expect); ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	SYLAR_ASSERT(s_inline_fired == expect);
+	SYLAR_ASSERT(s_task_fired == expect);
+
+	scheduler.Stop();
+	SYLAR_LOG_INFO(logger) << "timer dispatch test passed" << std::endl;
+}
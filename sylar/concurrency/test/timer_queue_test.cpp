@@ -0,0 +1,93 @@
+#include <concurrency/timer_queue.h>
+#include <concurrency/timing_wheel.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <random>
+#include <vector>
+#include <set>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const size_t kTimerNum = 20000;
+
+/// @brief 随机添加、撤销定时器并推进时间，检查每个定时器恰好到期一次，
+///		   既不早于其到期时间，也不晚于其所在的 tick(set 后端则须精确)
+static void TestBackend(const std::string& backend) {
+	auto queue = cc::TimerQueue::Create(backend);
+	const cc::Timer::Interval tolerance = backend == "wheel" ? cc::TimingWheel::kTickInterval : cc::Timer::Interval::zero();
+
+	std::mt19937_64 rng(42);
+	const auto base = std::chrono::steady_clock::now();
+	std::vector<cc::Timer::TimePoint> deadlines(kTimerNum + 1);
+	// (到期时间, id)
+	std::set<std::pair<cc::Timer::TimePoint, cc::Timer::TimerId>> alive;
+
+	for (cc::Timer::TimerId id = 1; id <= kTimerNum; ++id) {
+		cc::Timer::Interval delay;
+		switch (id % 10) {
+		case 0:		// 超出所有层，进入溢出链表
+			delay = std::chrono::hours(24 * 13) + std::chrono::nanoseconds(rng() % (uint64_t(1) << 40));
+			break;
+		case 1:		// 已经到期，且与其他定时器的到期时间相同
+			if (id % 20 == 1) {
+				delay = -std::chrono::milliseconds(1);
+				break;
+			}
+			delay = -std::chrono::nanoseconds(rng() % 1000000);
+			break;
+		default:
+			delay = std::chrono::nanoseconds(rng() % (uint64_t(1) << (20 + id % 20)));
+		}
+		deadlines[id] = base + delay;
+		queue->Push(cc::Timer(id, deadlines[id], cc::Timer::Interval::zero(), nullptr));
+		alive.emplace(deadlines[id], id);
+	}
+	SYLAR_ASSERT(queue->Size() == kTimerNum);
+
+	for (cc::Timer::TimerId id = 3; id <= kTimerNum; id += 3) {
+		SYLAR_ASSERT(queue->Erase(id));
+		SYLAR_ASSERT(!queue->Erase(id));
+		alive.erase({deadlines[id], id});
+	}
+	SYLAR_ASSERT(queue->Size() == alive.size());
+
+	auto now = base;
+	auto prev = cc::Timer::TimePoint::min();
+	std::vector<cc::Timer> expired;
+	while (!queue->Empty()) {
+		const auto next = queue->NextExpiration();
+		SYLAR_ASSERT(next != cc::Timer::TimePoint::max());
+		SYLAR_ASSERT(next <= std::max(alive.begin()->first, now) + tolerance);
+
+		// 随机小步推进，或直接跳至下一个需要检查的时间点
+		if (rng() % 8 == 0) {
+			now += std::chrono::nanoseconds(rng() % 5000000);
+		} else {
+			now = std::max(now, next) + std::chrono::nanoseconds(rng() % 1000);
+		}
+
+		expired.clear();
+		queue->PopExpired(now, expired);
+		for (const auto& timer : expired) {
+			SYLAR_ASSERT(alive.erase({deadlines[timer.id], timer.id}) == 1);
+			SYLAR_ASSERT(!queue->Contains(timer.id));
+			SYLAR_ASSERT(timer.timeout_tp == deadlines[timer.id]);
+			SYLAR_ASSERT(timer.timeout_tp <= now);
+			// 上一次推进时尚未到期
+			SYLAR_ASSERT(timer.timeout_tp + tolerance > prev);
+		}
+		SYLAR_ASSERT(queue->Size() == alive.size());
+		prev = now;
+	}
+	SYLAR_ASSERT(alive.empty());
+	SYLAR_LOG_INFO(logger) << "timer queue test passed, backend=" << backend << std::endl;
+}
+
+int main() {
+	TestBackend("set");
+	TestBackend("wheel");
+}
@@ -0,0 +1,101 @@
+#include <concurrency/scheduler.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const auto kInterval = std::chrono::milliseconds(10);
+static const auto kDuration = std::chrono::milliseconds(300);
+/// @brief 第 kStallAt 次回调阻塞 kStall，错过约 4 个周期
+static const int kStallAt = 5;
+static const auto kStall = std::chrono::milliseconds(45);
+
+/// @return 运行 kDuration 后 @a repeat 定时器的触发次数
+static int Run(cc::Timer::Repeat repeat) {
+	cc::Scheduler scheduler(1, false, "TimerRepeatScheduler");
+	scheduler.Start();
+
+	std::atomic<int> fired {0};
+	auto begin = std::chrono::steady_clock::now();
+	cc::Timer::TimerId id = scheduler.RunEvery(kInterval, [&fired, begin, repeat]() {
+		const int n = ++fired;
+		const auto now = std::chrono::steady_clock::now();
+		// 固定频率的定时器不早于其所在周期触发
+		if (repeat != cc::Timer::Repeat::kFixedRateBurst) {
+			SYLAR_ASSERT(now >= begin + kInterval * n);
+		}
+		if (n == kStallAt) {
+			// 以忙等阻塞处理定时器的线程
+			while (std::chrono::steady_clock::now() < now + kStall) {
+			}
+		}
+	}, repeat, true);
+
+	std::this_thread::sleep_for(kDuration);
+	scheduler.CancelTimer(id);
+	const int count = fired;
+	scheduler.Stop();
+	return count;
+}
+
+static std::atomic<int> s_copies {0};
+static std::atomic<int> s_counter_fired {0};
+
+/// @brief 记录被复制的次数，捕获的数据超出 std::function 的内联缓冲区
+struct CopyCounter {
+	CopyCounter() = default;
+	CopyCounter(const CopyCounter&) { ++s_copies; }
+	CopyCounter(CopyCounter&&) noexcept = default;
+
+	void operator()() const {
+		++s_counter_fired;
+	}
+
+	char payload[64] {};
+};
+
+/// @brief 重复定时器加入后，各周期的重新加入与执行均不复制回调
+static void CheckNoCopy(bool non_blocking) {
+	cc::Scheduler scheduler(1, false, "TimerNoCopyScheduler");
+	scheduler.Start();
+
+	s_copies = 0;
+	s_counter_fired = 0;
+	cc::Timer::TimerId id = scheduler.RunEvery(std::chrono::milliseconds(1), CopyCounter(),
+			cc::Timer::Repeat::kFixedDelay, non_blocking);
+	for (int i = 0; i < 2000 && s_counter_fired < 20; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	scheduler.CancelTimer(id);
+	scheduler.Stop();
+
+	SYLAR_ASSERT(s_counter_fired >= 20);
+	SYLAR_ASSERT(s_copies == 0);
+}
+
+/// @brief 固定频率的定时器不随处理延迟漂移，错过的周期按策略跳过或补发
+int main() {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kInfo);
+	const int periods = static_cast<int>(kDuration / kInterval);
+
+	const int burst = Run(cc::Timer::Repeat::kFixedRateBurst);
+	const int skip = Run(cc::Timer::Repeat::kFixedRateSkip);
+	const int delay = Run(cc::Timer::Repeat::kFixedDelay);
+	SYLAR_LOG_INFO(logger) << "periods=" << periods << ", burst=" << burst
+			<< ", skip=" << skip << ", delay=" << delay << std::endl;
+
+	SYLAR_ASSERT(burst >= periods - 3 && burst <= periods);
+	SYLAR_ASSERT(skip < burst && skip >= periods - 6);
+	SYLAR_ASSERT(delay <= skip);
+
+	CheckNoCopy(true);
+	CheckNoCopy(false);
+	SYLAR_LOG_INFO(logger) << "timer repeat test passed" << std::endl;
+}
@@ -0,0 +1,50 @@
+#include <concurrency/scheduler.h>
+#include <base/config.h>
+#include <base/debug.h>
+#include <base/log.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static auto logger = SYLAR_ROOT_LOGGER();
+
+static const int kTimerNum = 1000;
+static const uint64_t kSlackUs = 5000;
+
+static std::atomic<int> s_fired {0};
+
+/// @brief 定时器不早于其到期时间触发，到期时间相近的定时器共用一次 timerfd 到期
+int main() {
+	SYLAR_ROOT_LOGGER()->SetLogLevel(base::LogLevel::kInfo);
+	base::Singleton<base::ConfigManager>::GetInstance().Find<uint64_t>("timer.slack_us")->SetVal(kSlackUs);
+
+	cc::Scheduler scheduler(2, false, "TimerSlackScheduler");
+	scheduler.Start();
+
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<int> timeout_us(1000, 50000);
+	for (int i = 0; i < kTimerNum; ++i) {
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeout_us(rng));
+		scheduler.RunAt(deadline, [deadline]() {
+			SYLAR_ASSERT(std::chrono::steady_clock::now() >= deadline);
+			++s_fired;
+		});
+	}
+
+	for (int i = 0; i < 2000 && s_fired < kTimerNum; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	SYLAR_ASSERT(s_fired == kTimerNum);
+
+	// 到期时间分布于约 10 个桶中，每个桶至多设置一次 timerfd
+	const uint64_t set_count = scheduler.GetTimerFdSetCount();
+	SYLAR_ASSERT(set_count <= 50000 / kSlackUs + 5);
+
+	scheduler.Stop();
+	SYLAR_LOG_INFO(logger) << "timer slack test passed, timerfd_settime=" << set_count << std::endl;
+}
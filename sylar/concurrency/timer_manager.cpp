@@ -1,7 +1,9 @@
 #include <concurrency/timer_manager.h>
-#include <concurrency/epoll_poller.h>
+#include <concurrency/poller.h>
+#include <concurrency/scheduler.h>
 #include <base/log.h>
 #include <base/debug.h>
+#include <base/config.h>
 
 #include <sys/timerfd.h>
 #include <unistd.h>
@@ -14,6 +16,36 @@ static auto sys_logger = SYLAR_SYS_LOGGER();
 
 namespace {
 
+static auto g_timer_backend = base::Singleton<base::ConfigManager>::GetInstance()
+		.AddOrUpdate<std::string>("timer.backend", "wheel", "timer container: wheel (hierarchical timing wheel, 1ms resolution) or set (exact, ordered set)");
+
+static std::atomic<uint64_t> s_slack_us {1000};
+
+struct __InitTimerConfigHelper {
+	__InitTimerConfigHelper() {
+		auto& config = base::Singleton<base::ConfigManager>::GetInstance();
+
+		auto slack_us = config.AddOrUpdate<uint64_t>("timer.slack_us",
+				s_slack_us.load(), "microseconds a timer may fire late; deadlines are rounded up to multiples of it so that nearby timers share one timerfd expiration, 0 fires exactly");
+		slack_us->AddMonitor([](const uint64_t&, const uint64_t& now) {
+			s_slack_us.store(now, std::memory_order::memory_order_relaxed);
+		});
+	}
+};
+
+static __InitTimerConfigHelper s_init_timer_config_helper {};
+
+/// @brief 将 @a tp 向上取整至 timer.slack_us 的整数倍，即其所在桶的末尾
+static cc::Timer::TimePoint RoundUpToSlack(cc::Timer::TimePoint tp) {
+	const auto slack = std::chrono::duration_cast<cc::Timer::Interval>(
+			std::chrono::microseconds(s_slack_us.load(std::memory_order::memory_order_relaxed)));
+	if (slack == cc::Timer::Interval::zero() || tp == cc::Timer::TimePoint::max()) {
+		return tp;
+	}
+	const auto remainder = tp.time_since_epoch() % slack;
+	return remainder == cc::Timer::Interval::zero() ? tp : tp + (slack - remainder);
+}
+
 static int CreateTimerFd() {
     int fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
     if (fd == -1) {
@@ -23,33 +55,37 @@ static int CreateTimerFd() {
     return fd;
 }
 
-static std::atomic<cc::Timer::TimerId> gs_next_timer_id(1);
-
 } // namespace
 
-cc::TimerManager::TimerManager(EpollPoller* owner)
+cc::TimerManager::TimerManager(Poller* owner)
 	: owner_(owner)
 	, timerFd_(::CreateTimerFd())
+	, queue_(TimerQueue::Create(g_timer_backend->GetValue()))
 	, latestTime_(decltype(latestTime_)::max())
+	, cancelSlots_(kMaxSlotNum)
 	{}
 
 cc::TimerManager::~TimerManager() noexcept {
 	::close(timerFd_);
 }
 
-void cc::TimerManager::AddTimer(Timer timer) {
+cc::Timer::TimerId cc::TimerManager::AddTimer(Timer timer) {
 	SYLAR_ASSERT(timer.timeout_tp != decltype(timer.timeout_tp)::max());
 
 	std::lock_guard<std::mutex> guard(mutex_);
-	auto cur_timeout_tp = timer.timeout_tp;
-	bool latest_need_update = AddToHeap(std::move(timer));
-	if (latest_need_update) {
-		latestTime_ = cur_timeout_tp;
-		RefreshTimerFd();
+	DrainCancelRequests();
+	if (timer.IsRepeated() && timer.cb) {
+		timer.shared_cb = std::make_shared<std::function<void()>>(std::move(timer.cb));
+		timer.cb = nullptr;
 	}
+	timer.id = AllocateId();
+	const Timer::TimerId id = timer.id;
+	queue_->Push(std::move(timer));
+	UpdateLatestTime();
+	return id;
 }
 
-void cc::TimerManager::AddConditionTimer(Timer t, std::weak_ptr<void> cond) {
+cc::Timer::TimerId cc::TimerManager::AddConditionTimer(Timer t, std::weak_ptr<void> cond) {
 	auto copy = std::move(t.cb);
 	t.cb = [cb = std::move(copy), cond = std::move(cond)]() {
 		if (cond.lock()) {
@@ -58,30 +94,50 @@ void cc::TimerManager::AddConditionTimer(Timer t, std::weak_ptr<void> cond) {
 		}
 	};
 
-	AddTimer(std::move(t));
+	return AddTimer(std::move(t));
 }
 
 void cc::TimerManager::CancelTimer(Timer::TimerId target) {
 	std::lock_guard<std::mutex> guard(mutex_);
-	auto it = std::find_if(timerList_.begin(), timerList_.end(), [target](const Timer& t) {
-		return t.id == target;
-	});
+	DrainCancelRequests();
+	// do noting if not exist
+	if (EraseTimer(target)) {
+		UpdateLatestTime();
+	}
+}
+
+void cc::TimerManager::PostCancel(Timer::TimerId target) {
+	if (Timer::GetIdTag(target) != idTag_ || target == kInvalidTimerId) {
+		return;
+	}
+
+	// 节点在槽位创建时已分配
+	CancelSlot* slot = cancelSlots_.Find(Timer::GetIdSlot(target));
+	if (!slot) {
+		return;
+	}
+	// 只保留代数较新的 id，代数按回绕比较
+	Timer::TimerId pending = slot->pending.load(std::memory_order::memory_order_relaxed);
+	while (pending == kInvalidTimerId
+			|| static_cast<int32_t>(Timer::GetIdGeneration(target) - Timer::GetIdGeneration(pending)) > 0)
+	{
+		if (slot->pending.compare_exchange_weak(pending, target, std::memory_order::memory_order_seq_cst)) {
+			break;
+		}
+	}
 
-	// SYLAR_ASSERT(it != timerList_.end());	do noting if not exist
-	RemoveFromHeap(it);
+	// 与 DrainCancelRequests 配对：取出者先清除 queued 再读取 pending，不会遗漏此次请求
+	if (!slot->queued.exchange(true, std::memory_order::memory_order_seq_cst)) {
+		cancelMailbox_.Push(slot);
+	}
 }
 
 bool sylar::concurrency::TimerManager::HasTimer(Timer::TimerId id) {
 	std::lock_guard<std::mutex> guard(mutex_);
-	auto it = std::find_if(timerList_.begin(), timerList_.end(), [id](const Timer& t) {
-		return t.id == id;
-	});
-
-    return it != timerList_.end();
+	DrainCancelRequests();
+	return queue_->Contains(id);
 }
 
-
-
 void cc::TimerManager::HandleExpiredTimers() {
     uint64_t count = 0;
     int ret = ::read(timerFd_, &count, sizeof count);
@@ -92,44 +148,103 @@ void cc::TimerManager::HandleExpiredTimers() {
     }
 
     auto expired_timers = GetAllExpiredTimers();
+	// 可能阻塞的回调一次性提交，先于非阻塞回调的执行，使空闲线程尽早开始处理
+	Scheduler::TaskBatch batch;
+    for (auto& t : expired_timers) {
+		if (t.non_blocking) {
+			continue;
+		}
+		if (t.shared_cb) {
+			// 任务持有句柄，定时器于任务执行前被撤销也不影响回调的生命期
+			batch.Add([cb = std::move(t.shared_cb)]() {
+				(*cb)();
+			});
+		} else {
+			batch.Add(std::move(t.cb));
+		}
+    }
+	if (!batch.Empty()) {
+		owner_->GetScheduler()->Co(batch);
+	}
+
     for (auto& t : expired_timers) {
-		owner_->GetScheduler()->Co(std::move(t.cb));
+		if (!t.non_blocking) {
+			continue;
+		}
+		// 回调运行在空闲协程中，异常不能逃逸，否则空闲协程随之终止
+		try {
+			if (t.shared_cb) {
+				(*t.shared_cb)();
+			} else {
+				t.cb();
+			}
+		} catch (const std::exception& e) {
+			SYLAR_LOG_FMT_ERROR(sys_logger,
+					"non-blocking timer %lu caught a std exception: %s\nBacktrace:\n%s\n",
+					t.id, e.what(), base::BacktraceToString(2, "\t").c_str());
+		} catch (...) {
+			SYLAR_LOG_FMT_ERROR(sys_logger,
+					"non-blocking timer %lu caught a unknown exception\nBacktrace:\n%s\n",
+					t.id, base::BacktraceToString(2, "\t").c_str());
+		}
     }
 }
 
-cc::Timer::TimerId cc::TimerManager::GetNextTimerId() {
-	return gs_next_timer_id.fetch_add(1, std::memory_order::memory_order_relaxed);
+cc::Timer::TimerId cc::TimerManager::AllocateId() {
+	uint32_t slot;
+	if (!freeSlots_.empty()) {
+		slot = freeSlots_.front();
+		freeSlots_.pop_front();
+	} else {
+		SYLAR_ASSERT_WITH_MSG(generations_.size() < kMaxSlotNum, "too many timers in a TimerManager");
+		slot = static_cast<uint32_t>(generations_.size());
+		generations_.push_back(1);
+		// 预先分配撤销请求节点，使投递撤销无需分配内存
+		cancelSlots_.Get(slot);
+	}
+	return Timer::MakeId(idTag_, generations_[slot], slot);
 }
 
-bool cc::TimerManager::AddToHeap(Timer&& timer) {
-	bool latest_need_update = false;
-	if (timerList_.empty() || timerList_.begin()->timeout_tp > timer.timeout_tp) {
-		latest_need_update = true;
+void cc::TimerManager::ReleaseId(Timer::TimerId id) {
+	const uint32_t slot = Timer::GetIdSlot(id);
+	// 回绕时跳过 0
+	if (++generations_[slot] == 0) {
+		generations_[slot] = 1;
 	}
-
-	timerList_.insert(std::move(timer));
-
-	return latest_need_update;
+	freeSlots_.push_back(slot);
 }
 
-void cc::TimerManager::RemoveFromHeap(std::set<cc::Timer>::iterator it) {
-	bool latest_need_update = false;
-	if (timerList_.size() == 1 || it == timerList_.begin()) {
-		latest_need_update = true;
+bool cc::TimerManager::EraseTimer(Timer::TimerId id) {
+	// 其他实例的或已失效的 id 不会命中
+	if (Timer::GetIdTag(id) != idTag_ || !queue_->Erase(id)) {
+		return false;
 	}
+	ReleaseId(id);
+	return true;
+}
 
-	timerList_.erase(it);
-
-	if (latest_need_update) {
-		if (timerList_.empty()) {
-			latestTime_ = decltype(latestTime_)::max();
-		} else {
-			latestTime_ = timerList_.begin()->timeout_tp;
+void cc::TimerManager::DrainCancelRequests() {
+	bool erased = false;
+	while (CancelSlot* slot = cancelMailbox_.Pop()) {
+		slot->queued.store(false, std::memory_order::memory_order_seq_cst);
+		const Timer::TimerId id = slot->pending.exchange(kInvalidTimerId, std::memory_order::memory_order_seq_cst);
+		if (id != kInvalidTimerId) {
+			erased |= EraseTimer(id);
 		}
+	}
+	if (erased) {
+		UpdateLatestTime();
+	}
+}
 
+void cc::TimerManager::UpdateLatestTime() {
+	// 只在最早的桶早于 timerfd 的到期时间时重新设置；晚于它时(如最早的定时器被撤销)保留原设置，
+	// 以一次提前的唤醒代替一次 timerfd_settime
+	const Timer::TimePoint next = RoundUpToSlack(queue_->NextExpiration());
+	if (next < latestTime_) {
+		latestTime_ = next;
 		RefreshTimerFd();
 	}
-
 }
 
 void cc::TimerManager::RefreshTimerFd() {
@@ -146,6 +261,7 @@ void cc::TimerManager::RefreshTimerFd() {
         new_t.it_value.tv_nsec = static_cast<decltype(itimerspec::it_value.tv_nsec)>(nsec.count());
     }
 
+	timerFdSets_.fetch_add(1, std::memory_order::memory_order_relaxed);
 	int ret = ::timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &new_t, &old_t);
 	if (ret < 0) {
 		SYLAR_LOG_ERROR(sys_logger)
@@ -158,31 +274,28 @@ std::vector<cc::Timer> cc::TimerManager::GetAllExpiredTimers() {
 	std::vector<Timer> expired_timers;
 
 	std::lock_guard<std::mutex> guard(mutex_);
-
-	while (!timerList_.empty() && timerList_.begin()->timeout_tp <= std::chrono::steady_clock::now()) {
-		auto it = timerList_.begin();
-		expired_timers.push_back(*it);
-		if (it->IsRepeated()) {
-			auto next_expiration = it->interval + std::chrono::steady_clock::now();
-
-			Timer next_timer = *it;
-			next_timer.SetExpiration(next_expiration);
-
-			timerList_.erase(it);
-			timerList_.insert(std::move(next_timer));
+	DrainCancelRequests();
+
+	// 与 timerfd 同为 CLOCK_MONOTONIC 的精确读数，缓存的或粗粒度的时间可能早于 timerfd 的到期时间，
+	// 使到期的定时器无法取出而 timerfd 被立即重新设置
+	const Timer::TimePoint now = std::chrono::steady_clock::now();
+	queue_->PopExpired(now, expired_timers);
+	for (const auto& timer : expired_timers) {
+		if (timer.IsRepeated()) {
+			// 重复定时器沿用原有的 id，回调位于共享的句柄中，复制定时器不复制回调
+			Timer next_timer = timer;
+			next_timer.SetExpiration(timer.NextExpiration(now));
+			queue_->Push(std::move(next_timer));
 		} else {
-			timerList_.erase(it);
+			ReleaseId(timer.id);
 		}
 	}
 
-	if (timerList_.empty()) {
-		latestTime_ = decltype(latestTime_)::max();
-	} else {
-		SYLAR_ASSERT(timerList_.begin()->timeout_tp > latestTime_);
-		latestTime_ = timerList_.begin()->timeout_tp;
+	// 已到期的 timerfd 不再触发，需按剩余的定时器重新设置；提前的唤醒则保留原设置
+	if (latestTime_ <= now) {
+		latestTime_ = Timer::TimePoint::max();
 	}
-
-	RefreshTimerFd();
+	UpdateLatestTime();
 
     return expired_timers;
 }
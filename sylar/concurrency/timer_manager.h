@@ -1,6 +1,11 @@
 #pragma once
 
-#include <set>
+#include <concurrency/timer_queue.h>
+#include <concurrency/mpsc_queue.h>
+#include <concurrency/chunked_table.h>
+
+#include <atomic>
+#include <deque>
 #include <mutex>
 #include <chrono>
 #include <memory>
@@ -9,71 +14,99 @@
 namespace sylar {
 namespace concurrency {
 
-class EpollPoller;
-
-struct Timer {
-	using TimerId = uint32_t;
-	using TimePoint = std::chrono::steady_clock::time_point;
-	using Interval = std::chrono::steady_clock::duration;
-
-	explicit Timer(TimerId a_id, TimePoint a_timeout_tp, Interval a_interval, std::function<void()> a_cb)
-		: id(a_id)
-		, timeout_tp(std::move(a_timeout_tp))
-		, interval(std::move(a_interval))
-		, cb(std::move(a_cb))
-		{}
-
-	bool operator<(const Timer& other) const {
-		return this->timeout_tp < other.timeout_tp;
-	}
-
-	bool IsRepeated() const
-	{ return interval != Interval::zero(); }
-
-	void SetExpiration(TimePoint tp)
-	{ timeout_tp = tp; }
-
-	TimerId id;
-	TimePoint timeout_tp;
-	Interval interval;
-	std::function<void()> cb;
-};
+class Poller;
 
+/// @brief 一组定时器及其 timerfd，由所属 poller 等待
+///
+///		   调度器为每个调度线程各配置一个，另有一个供非调度线程使用；
+///		   定时器 id 由本实例分配，自高位起依次为 [标签:8][代数:32][槽位:24]；
+///		   标签标识所属的 TimerManager，据此将撤销请求路由至对应的实例
 class TimerManager {
 public:
-	explicit TimerManager(EpollPoller* owner);
+	explicit TimerManager(Poller* owner);
 
 	~TimerManager() noexcept;
 
 	int GetTimerFd() const
 	{ return timerFd_; }
 
-	void AddTimer(Timer);
+	/// @brief 为定时器分配 id 并加入
+	/// @return 分配的 id，在定时器到期(重复定时器被撤销)前有效
+	Timer::TimerId AddTimer(Timer);
 
-	void AddConditionTimer(Timer, std::weak_ptr<void> cond);
+	Timer::TimerId AddConditionTimer(Timer, std::weak_ptr<void> cond);
 
 	void CancelTimer(Timer::TimerId);
 
+	/// @brief 以无锁的方式投递撤销请求，于该实例下一次加锁操作时生效，任意线程可调用
+	///
+	///		   请求节点内嵌于槽位，投递不分配内存
+	void PostCancel(Timer::TimerId);
+
 	bool HasTimer(Timer::TimerId);
 
 	void HandleExpiredTimers();
 
-	static Timer::TimerId GetNextTimerId();
+	/// @brief 设置本实例的标签，需在添加定时器前调用
+	void SetIdTag(uint8_t tag)
+	{ idTag_ = tag; }
+
+	/// @brief 调用 timerfd_settime 的次数
+	uint64_t GetTimerFdSetCount() const
+	{ return timerFdSets_.load(std::memory_order::memory_order_relaxed); }
 
 public:
 	constexpr static const Timer::TimerId kInvalidTimerId = 0;
 
 private:
-	bool AddToHeap(Timer&& timer);
-	void RemoveFromHeap(std::set<concurrency::Timer>::iterator);
+	/// @brief 槽位内嵌的撤销请求节点，同一时刻至多位于邮箱中一次
+	struct CancelSlot : MpscQueueHook {
+		/// @brief 待撤销的 id 中代数最新的一个；同一槽位上较新的 id 存在时，较旧的 id 必已失效
+		std::atomic<Timer::TimerId> pending {kInvalidTimerId};
+		/// @brief 是否已位于邮箱中
+		std::atomic<bool> queued {false};
+	};
+
+	/// @brief 同时存在的定时器数量上限，小于 id 中槽位字段的范围，以限制撤销节点表的目录大小
+	static constexpr size_t kMaxSlotNum = size_t(1) << 20;
+	static_assert(kMaxSlotNum <= (size_t(1) << Timer::kIdSlotBits), "slot field of TimerId");
+	/// @brief 撤销节点表每块的槽位数
+	static constexpr size_t kCancelSlotChunkSize = 256;
+
+	/// @brief 处理已投递的撤销请求，需持有 mutex_
+	void DrainCancelRequests();
+
+	/// @brief 分配空闲的槽位及其当前代数，需持有 mutex_
+	Timer::TimerId AllocateId();
+
+	/// @brief 释放 @a id 的槽位并递增其代数，需持有 mutex_
+	void ReleaseId(Timer::TimerId id);
+
+	/// @brief 从队列中移除 @a id 并释放其槽位，需持有 mutex_
+	bool EraseTimer(Timer::TimerId id);
+
+	/// @brief 最早的定时器所在的桶(见配置 timer.slack_us)早于 timerfd 的到期时间时重新设置 timerfd
+	void UpdateLatestTime();
 	void RefreshTimerFd();
 	std::vector<Timer> GetAllExpiredTimers();
 
-public:
-	EpollPoller* owner_;
+private:
+	Poller* owner_;
 	int timerFd_;
-	std::set<Timer> timerList_;
+	/// @brief 由配置 timer.backend 选择
+	std::unique_ptr<TimerQueue> queue_;
+	/// @brief timerfd 的到期时间，不晚于最早的定时器所在的桶，未设置时为 TimePoint::max()
 	Timer::TimePoint latestTime_;
+	std::atomic<uint64_t> timerFdSets_ {0};
+	uint8_t idTag_ = 0;
+	/// @brief 各槽位的当前代数，从 1 开始，使 id 不为 kInvalidTimerId
+	std::vector<uint32_t> generations_;
+	/// @brief 先进先出地复用槽位，使各槽位的代数均匀增长
+	std::deque<uint32_t> freeSlots_;
+	/// @brief 以槽位为下标的撤销请求节点，于槽位创建时分块分配，其他线程无需加锁即可获取
+	ChunkedTable<CancelSlot, kCancelSlotChunkSize> cancelSlots_;
+	/// @brief 其他线程投递的撤销请求，仅在持有 mutex_ 时取出
+	MpscQueue<CancelSlot> cancelMailbox_;
 	mutable std::mutex mutex_;
 };
 
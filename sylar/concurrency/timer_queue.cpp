@@ -0,0 +1,66 @@
+#include <concurrency/timer_queue.h>
+#include <concurrency/timing_wheel.h>
+#include <base/log.h>
+#include <base/debug.h>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+cc::Timer::TimePoint cc::Timer::NextExpiration(TimePoint now) const {
+	switch (repeat) {
+	case Repeat::kFixedRateSkip:
+		if (timeout_tp + interval <= now) {
+			// 跳至晚于 now 的第一个周期，与最初的到期时间保持对齐
+			return timeout_tp + ((now - timeout_tp) / interval + 1) * interval;
+		}
+		return timeout_tp + interval;
+	case Repeat::kFixedRateBurst:
+		return timeout_tp + interval;
+	case Repeat::kFixedDelay:
+	default:
+		return now + interval;
+	}
+}
+
+std::unique_ptr<cc::TimerQueue> cc::TimerQueue::Create(const std::string& backend) {
+	if (backend == "wheel") {
+		return std::make_unique<TimingWheel>();
+	}
+	if (backend != "set") {
+		SYLAR_LOG_WARN(SYLAR_ROOT_LOGGER()) << "unknown timer backend \"" << backend
+				<< "\", fall back to set" << std::endl;
+	}
+	return std::make_unique<SetTimerQueue>();
+}
+
+void cc::SetTimerQueue::Push(Timer timer) {
+	const Timer::TimerId id = timer.id;
+	auto pair = timerList_.insert(std::move(timer));
+	SYLAR_ASSERT(pair.second);
+	index_.Insert(id, pair.first);
+}
+
+bool cc::SetTimerQueue::Erase(Timer::TimerId id) {
+	auto it = index_.Find(id);
+
+	// do noting if not exist
+	if (it == nullptr) {
+		return false;
+	}
+	timerList_.erase(*it);
+	index_.Erase(id);
+	return true;
+}
+
+cc::Timer::TimePoint cc::SetTimerQueue::NextExpiration() const {
+	return timerList_.empty() ? Timer::TimePoint::max() : timerList_.begin()->timeout_tp;
+}
+
+void cc::SetTimerQueue::PopExpired(Timer::TimePoint now, std::vector<Timer>& expired) {
+	while (!timerList_.empty() && timerList_.begin()->timeout_tp <= now) {
+		// 取出节点后即可移动其中的回调，无需拷贝
+		auto node = timerList_.extract(timerList_.begin());
+		index_.Erase(node.value().id);
+		expired.push_back(std::move(node.value()));
+	}
+}
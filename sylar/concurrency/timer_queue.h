@@ -0,0 +1,196 @@
+#pragma once
+
+#include <base/debug.h>
+
+#include <set>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace sylar {
+namespace concurrency {
+
+struct Timer {
+	/// @brief 高 kIdTagBits 位为所属 TimerManager 的标签，其后 kIdGenerationBits 位为槽位的代数，
+	///		   低 kIdSlotBits 位为槽位；槽位被复用时代数递增，因此持有旧 id 的撤销与查找不会命中新的定时器
+	using TimerId = uint64_t;
+	using TimePoint = std::chrono::steady_clock::time_point;
+	using Interval = std::chrono::steady_clock::duration;
+
+	/// @brief 重复定时器下一次的到期时间
+	enum class Repeat : uint8_t {
+		kFixedDelay,		///< 本次处理时刻 + interval，随处理延迟漂移
+		kFixedRateSkip,		///< 上次到期时间 + interval，跳过已错过的周期
+		kFixedRateBurst		///< 上次到期时间 + interval，已错过的周期依次立即补发
+	};
+
+	explicit Timer(TimerId a_id, TimePoint a_timeout_tp, Interval a_interval, std::function<void()> a_cb
+			, bool a_non_blocking = false, Repeat a_repeat = Repeat::kFixedDelay)
+		: id(a_id)
+		, timeout_tp(std::move(a_timeout_tp))
+		, interval(std::move(a_interval))
+		, cb(std::move(a_cb))
+		, non_blocking(a_non_blocking)
+		, repeat(a_repeat)
+		{}
+
+	static constexpr unsigned kIdSlotBits = 24;
+	static constexpr unsigned kIdGenerationBits = 32;
+	static constexpr unsigned kIdTagBits = 8;
+	static_assert(kIdSlotBits + kIdGenerationBits + kIdTagBits == sizeof(TimerId) * 8, "TimerId layout");
+
+	static TimerId MakeId(uint8_t tag, uint32_t generation, uint32_t slot) {
+		return static_cast<TimerId>(tag) << (kIdSlotBits + kIdGenerationBits)
+			| static_cast<TimerId>(generation) << kIdSlotBits
+			| slot;
+	}
+
+	static uint8_t GetIdTag(TimerId id)
+	{ return static_cast<uint8_t>(id >> (kIdSlotBits + kIdGenerationBits)); }
+
+	static uint32_t GetIdGeneration(TimerId id)
+	{ return static_cast<uint32_t>(id >> kIdSlotBits); }
+
+	static uint32_t GetIdSlot(TimerId id)
+	{ return static_cast<uint32_t>(id & ((TimerId(1) << kIdSlotBits) - 1)); }
+
+	/// @brief 按 (到期时间, id) 排序，到期时间相同的定时器互不覆盖
+	bool operator<(const Timer& other) const {
+		return this->timeout_tp < other.timeout_tp
+			|| (this->timeout_tp == other.timeout_tp && this->id < other.id);
+	}
+
+	bool IsRepeated() const
+	{ return interval != Interval::zero(); }
+
+	void SetExpiration(TimePoint tp)
+	{ timeout_tp = tp; }
+
+	/// @brief 按 repeat 计算于 @a now 处理后下一次的到期时间
+	TimePoint NextExpiration(TimePoint now) const;
+
+	TimerId id;
+	TimePoint timeout_tp;
+	Interval interval;
+	std::function<void()> cb;
+	/// @brief 重复定时器的回调，加入时由 cb 移入；每个周期重新加入时只复制该句柄而非回调本身。
+	///		   各周期的任务共用同一回调对象，非 non_blocking 的周期相互重叠时可能被并发调用
+	std::shared_ptr<std::function<void()>> shared_cb;
+	/// @brief 回调不会阻塞或挂起，到期后直接在处理 timerfd 的线程上执行，而非作为任务提交
+	bool non_blocking;
+	Repeat repeat;
+};
+
+/// @brief 以定时器 id 中的槽位为下标的索引，添加、撤销与查找均为 O(1)
+///
+///		   槽位中记录完整的 id，代数不符(槽位已被其他定时器复用)的 id 视为不存在
+/// @tparam T  定时器在容器中的位置，如节点指针或迭代器
+template <typename T>
+class TimerIndex {
+public:
+	void Insert(Timer::TimerId id, T value) {
+		const uint32_t slot = Timer::GetIdSlot(id);
+		if (slot >= entries_.size()) {
+			entries_.resize(slot + 1);
+		}
+		Entry& entry = entries_[slot];
+		SYLAR_ASSERT(!entry.used);
+		entry.id = id;
+		entry.value = std::move(value);
+		entry.used = true;
+		++size_;
+	}
+
+	/// @return @a id 对应的位置，不存在时返回 nullptr
+	const T* Find(Timer::TimerId id) const {
+		const uint32_t slot = Timer::GetIdSlot(id);
+		if (slot >= entries_.size() || !entries_[slot].used || entries_[slot].id != id) {
+			return nullptr;
+		}
+		return &entries_[slot].value;
+	}
+
+	/// @brief 移除 @a id，其须存在
+	void Erase(Timer::TimerId id) {
+		Entry& entry = entries_[Timer::GetIdSlot(id)];
+		SYLAR_ASSERT(entry.used && entry.id == id);
+		entry.used = false;
+		--size_;
+	}
+
+	template <typename Func>
+	void ForEach(Func&& func) const {
+		for (const auto& entry : entries_) {
+			if (entry.used) {
+				func(entry.value);
+			}
+		}
+	}
+
+	size_t Size() const
+	{ return size_; }
+
+private:
+	struct Entry {
+		Timer::TimerId id = 0;
+		T value {};
+		bool used = false;
+	};
+
+	std::vector<Entry> entries_;
+	size_t size_ = 0;
+};
+
+/// @brief 按到期时间组织定时器的容器，由 TimerManager 加锁后访问
+class TimerQueue {
+public:
+	/// @brief 按名称创建后端: set 或 wheel，未知的名称退回 set
+	static std::unique_ptr<TimerQueue> Create(const std::string& backend);
+
+	virtual ~TimerQueue() noexcept = default;
+
+	virtual void Push(Timer timer) = 0;
+
+	/// @return 是否存在并移除了 @a id 对应的定时器
+	virtual bool Erase(Timer::TimerId id) = 0;
+
+	virtual bool Contains(Timer::TimerId id) const = 0;
+
+	/// @brief 应当检查到期定时器的最早时间点，不晚于最早的到期时间；为空时返回 TimePoint::max()
+	virtual Timer::TimePoint NextExpiration() const = 0;
+
+	/// @brief 取出所有到期时间不晚于 @a now 的定时器，追加至 @a expired
+	virtual void PopExpired(Timer::TimePoint now, std::vector<Timer>& expired) = 0;
+
+	virtual size_t Size() const = 0;
+
+	bool Empty() const
+	{ return Size() == 0; }
+};
+
+/// @brief 以 std::set 按 (到期时间, id) 排序，并以 id 索引其节点，撤销与查找无需扫描
+class SetTimerQueue : public TimerQueue {
+public:
+	void Push(Timer timer) override;
+
+	bool Erase(Timer::TimerId id) override;
+
+	bool Contains(Timer::TimerId id) const override
+	{ return index_.Find(id) != nullptr; }
+
+	Timer::TimePoint NextExpiration() const override;
+
+	void PopExpired(Timer::TimePoint now, std::vector<Timer>& expired) override;
+
+	size_t Size() const override
+	{ return timerList_.size(); }
+
+private:
+	std::set<Timer> timerList_;
+	TimerIndex<std::set<Timer>::iterator> index_;
+};
+
+} // namespace concurrency
+} // namespace sylar
@@ -0,0 +1,183 @@
+#include <concurrency/timing_wheel.h>
+#include <base/debug.h>
+
+#include <limits>
+#include <algorithm>
+
+using namespace sylar;
+namespace cc = sylar::concurrency;
+
+static_assert(cc::TimingWheel::kSlotNum == 64, "slot bitmaps are 64-bit");
+
+static constexpr cc::TimingWheel::Tick kNoTick = std::numeric_limits<cc::TimingWheel::Tick>::max();
+
+cc::TimingWheel::TimingWheel()
+	: currentTick_(ToTickFloor(std::chrono::steady_clock::now()))
+	{}
+
+cc::TimingWheel::~TimingWheel() noexcept {
+	index_.ForEach([](Node* node) {
+		delete node;
+	});
+}
+
+cc::TimingWheel::Tick cc::TimingWheel::ToTick(Timer::TimePoint tp) {
+	const auto ticks = tp.time_since_epoch().count();
+	const auto tick_interval = kTickInterval.count();
+	return static_cast<Tick>((ticks + tick_interval - 1) / tick_interval);
+}
+
+cc::TimingWheel::Tick cc::TimingWheel::ToTickFloor(Timer::TimePoint tp) {
+	return static_cast<Tick>(tp.time_since_epoch().count() / kTickInterval.count());
+}
+
+cc::Timer::TimePoint cc::TimingWheel::ToTimePoint(Tick tick) {
+	return Timer::TimePoint(kTickInterval * tick);
+}
+
+void cc::TimingWheel::Push(Timer timer) {
+	const Timer::TimerId id = timer.id;
+	// 已到期的定时器于下一个 tick 处理
+	const Tick expire_tick = std::max(ToTick(timer.timeout_tp), currentTick_ + 1);
+	Node* node = new Node(std::move(timer), expire_tick);
+	index_.Insert(id, node);
+	Link(node);
+}
+
+bool cc::TimingWheel::Erase(Timer::TimerId id) {
+	auto it = index_.Find(id);
+	if (it == nullptr) {
+		return false;
+	}
+
+	Node* node = *it;
+	index_.Erase(id);
+	Unlink(node);
+	delete node;
+	return true;
+}
+
+cc::Timer::TimePoint cc::TimingWheel::NextExpiration() const {
+	const Tick tick = NextTick();
+	return tick == kNoTick ? Timer::TimePoint::max() : ToTimePoint(tick);
+}
+
+void cc::TimingWheel::PopExpired(Timer::TimePoint now, std::vector<Timer>& expired) {
+	const Tick now_tick = ToTickFloor(now);
+
+	while (true) {
+		const Tick tick = NextTick();
+		if (tick > now_tick) {
+			// 直至 now_tick 均无槽位需要处理，可直接跳过
+			currentTick_ = std::max(currentTick_, now_tick);
+			break;
+		}
+		currentTick_ = tick;
+
+		// 自高层向低层，将以 tick 为起点的槽位重新分配
+		for (size_t level = kLevelNum; level > 0; --level) {
+			if ((tick & ((Tick(1) << (level * kSlotBits)) - 1)) != 0) {
+				continue;
+			}
+
+			const size_t slot = (tick >> (level * kSlotBits)) & (kSlotNum - 1);
+			Node*& head = SlotHead(level, slot);
+			Node* list = head;
+			head = nullptr;
+			if (level < kLevelNum) {
+				bitmaps_[level] &= ~(uint64_t(1) << slot);
+			}
+			Redistribute(list, expired);
+		}
+
+		// 最底层槽位中的定时器均于此 tick 到期
+		const size_t slot = tick & (kSlotNum - 1);
+		Node* list = slots_[0][slot];
+		slots_[0][slot] = nullptr;
+		bitmaps_[0] &= ~(uint64_t(1) << slot);
+		while (list) {
+			Node* next = list->next;
+			SYLAR_ASSERT(list->expire_tick == tick);
+			Expire(list, expired);
+			list = next;
+		}
+	}
+}
+
+void cc::TimingWheel::Link(Node* node) {
+	SYLAR_ASSERT(node->expire_tick > currentTick_);
+
+	// 到期 tick 与当前 tick 的高位相同，其所在层的槽位下标必然大于当前下标
+	const Tick diff = node->expire_tick ^ currentTick_;
+	size_t level = diff < kSlotNum ? 0 : (63 - static_cast<size_t>(__builtin_clzll(diff))) / kSlotBits;
+	size_t slot = 0;
+	if (level >= kLevelNum) {
+		level = kLevelNum;
+	} else {
+		slot = (node->expire_tick >> (level * kSlotBits)) & (kSlotNum - 1);
+		bitmaps_[level] |= uint64_t(1) << slot;
+	}
+
+	node->level = static_cast<uint8_t>(level);
+	node->slot = static_cast<uint8_t>(slot);
+	Node*& head = SlotHead(level, slot);
+	node->prev = nullptr;
+	node->next = head;
+	if (head) {
+		head->prev = node;
+	}
+	head = node;
+}
+
+void cc::TimingWheel::Unlink(Node* node) {
+	Node*& head = SlotHead(node->level, node->slot);
+	if (node->prev) {
+		node->prev->next = node->next;
+	} else {
+		head = node->next;
+	}
+	if (node->next) {
+		node->next->prev = node->prev;
+	}
+
+	if (head == nullptr && node->level < kLevelNum) {
+		bitmaps_[node->level] &= ~(uint64_t(1) << node->slot);
+	}
+}
+
+void cc::TimingWheel::Redistribute(Node* head, std::vector<Timer>& expired) {
+	while (head) {
+		Node* next = head->next;
+		if (head->expire_tick <= currentTick_) {
+			Expire(head, expired);
+		} else {
+			Link(head);
+		}
+		head = next;
+	}
+}
+
+void cc::TimingWheel::Expire(Node* node, std::vector<Timer>& expired) {
+	index_.Erase(node->timer.id);
+	expired.push_back(std::move(node->timer));
+	delete node;
+}
+
+cc::TimingWheel::Tick cc::TimingWheel::NextTick() const {
+	// 低层槽位的起点总是早于高层槽位的起点
+	for (size_t level = 0; level < kLevelNum; ++level) {
+		const size_t shift = level * kSlotBits;
+		const size_t cur_slot = (currentTick_ >> shift) & (kSlotNum - 1);
+		uint64_t mask = cur_slot == kSlotNum - 1 ? 0 : bitmaps_[level] & ~((uint64_t(2) << cur_slot) - 1);
+		if (mask) {
+			const Tick base = (currentTick_ >> (shift + kSlotBits)) << (shift + kSlotBits);
+			return base | (Tick(__builtin_ctzll(mask)) << shift);
+		}
+	}
+
+	if (overflow_) {
+		const size_t shift = kLevelNum * kSlotBits;
+		return ((currentTick_ >> shift) + 1) << shift;
+	}
+	return kNoTick;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <concurrency/timer_queue.h>
+
+namespace sylar {
+namespace concurrency {
+
+/// @brief 分层时间轮
+///
+///		   - 以 kTickInterval 为一个 tick，到期时间向上取整至 tick，因此定时器至多延迟一个 tick 触发，但不会提前
+///		   - 共 kLevelNum 层，每层 kSlotNum 个槽位，第 l 层的一个槽位跨越 kSlotNum^l 个 tick；
+///		     到期 tick 与当前 tick 的最高不同位落在哪一层，定时器便放在哪一层，超出所有层的放入溢出链表
+///		   - 时间推进至高层某一槽位的起点时，其中的定时器被重新分配至更低的层
+///		   - 每层以位图记录非空的槽位，据此直接跳至下一个需要处理的 tick，无需逐个 tick 推进
+///		   - 按 id 查找经由以槽位为下标的 TimerIndex，添加、撤销与查找均为 O(1)
+class TimingWheel : public TimerQueue {
+public:
+	using Tick = uint64_t;
+
+	static constexpr Timer::Interval kTickInterval = std::chrono::milliseconds(1);
+	static constexpr size_t kSlotBits = 6;
+	static constexpr size_t kSlotNum = size_t(1) << kSlotBits;
+	/// @brief 各层共覆盖 2^30 个 tick(约 12 天)
+	static constexpr size_t kLevelNum = 5;
+
+	TimingWheel();
+
+	~TimingWheel() noexcept override;
+
+	void Push(Timer timer) override;
+
+	bool Erase(Timer::TimerId id) override;
+
+	bool Contains(Timer::TimerId id) const override
+	{ return index_.Find(id) != nullptr; }
+
+	Timer::TimePoint NextExpiration() const override;
+
+	void PopExpired(Timer::TimePoint now, std::vector<Timer>& expired) override;
+
+	size_t Size() const override
+	{ return index_.Size(); }
+
+private:
+	TimingWheel(const TimingWheel&) = delete;
+	TimingWheel& operator=(const TimingWheel&) = delete;
+
+	struct Node {
+		Node(Timer&& a_timer, Tick a_expire_tick)
+			: timer(std::move(a_timer))
+			, expire_tick(a_expire_tick)
+			{}
+
+		Timer timer;
+		Tick expire_tick;
+		/// @brief 所在的层与槽位，溢出链表的层为 kLevelNum
+		uint8_t level = 0;
+		uint8_t slot = 0;
+		Node* prev = nullptr;
+		Node* next = nullptr;
+	};
+
+	/// @brief 向上取整至 tick
+	static Tick ToTick(Timer::TimePoint tp);
+
+	/// @brief 向下取整至 tick
+	static Tick ToTickFloor(Timer::TimePoint tp);
+
+	static Timer::TimePoint ToTimePoint(Tick tick);
+
+	Node*& SlotHead(size_t level, size_t slot)
+	{ return level == kLevelNum ? overflow_ : slots_[level][slot]; }
+
+	/// @brief 按相对 currentTick_ 的距离将 @a node 放入对应的槽位
+	void Link(Node* node);
+
+	void Unlink(Node* node);
+
+	/// @brief 将链表 @a head 中已到期的定时器移入 @a expired，其余重新分配槽位
+	void Redistribute(Node* head, std::vector<Timer>& expired);
+
+	void Expire(Node* node, std::vector<Timer>& expired);
+
+	/// @brief 下一个需要处理的 tick: 某一非空槽位的起点，或溢出链表非空时最高层的下一轮起点
+	/// @return 无定时器时返回 Tick 的最大值
+	Tick NextTick() const;
+
+private:
+	/// @brief 已处理至的 tick，所有定时器的到期 tick 均大于它
+	Tick currentTick_;
+	Node* slots_[kLevelNum][kSlotNum] {};
+	Node* overflow_ = nullptr;
+	uint64_t bitmaps_[kLevelNum] {};
+	TimerIndex<Node*> index_;
+};
+
+} // namespace concurrency
+} // namespace sylar
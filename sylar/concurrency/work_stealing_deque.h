@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace sylar {
+namespace concurrency {
+
+/// @brief Chase-Lev 无锁工作窃取双端队列
+///
+///		   - 仅所有者线程可以调用 Push/Pop，操作队列底部(LIFO)
+///		   - 任意线程可以调用 Steal，从队列顶部(FIFO)窃取
+///		   - 容量不足时由所有者线程扩容，旧缓冲区在队列析构时才释放，
+///		     以保证并发窃取者读取旧缓冲区的安全
+///
+///		   参考: Lê N.M. et al. Correct and Efficient Work-Stealing for Weak Memory Models. PPoPP'13
+/// @tparam T  元素类型，队列中存放的是 T*
+template <typename T>
+class WorkStealingDeque {
+public:
+	explicit WorkStealingDeque(size_t capacity = 256);
+
+	~WorkStealingDeque() noexcept = default;
+
+	/// @brief 压入队列底部，仅所有者线程可调用
+	void Push(T* item);
+
+	/// @brief 弹出队列底部，仅所有者线程可调用
+	/// @return 队列为空时返回 nullptr
+	T* Pop();
+
+	/// @brief 从队列顶部窃取，任意线程可调用
+	/// @return 队列为空或与其他线程竞争失败时返回 nullptr
+	T* Steal();
+
+	/// @brief 队列中元素数量的近似值
+	size_t Size() const {
+		int64_t b = bottom_.load(std::memory_order::memory_order_relaxed);
+		int64_t t = top_.load(std::memory_order::memory_order_relaxed);
+		return b > t ? static_cast<size_t>(b - t) : 0;
+	}
+
+	bool Empty() const
+	{ return Size() == 0; }
+
+private:
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+	struct Buffer {
+		explicit Buffer(size_t cap)
+			: capacity(static_cast<int64_t>(cap))
+			, mask(static_cast<int64_t>(cap) - 1)
+			, slots(new std::atomic<T*>[cap])
+			{}
+
+		T* Get(int64_t i) const
+		{ return slots[i & mask].load(std::memory_order::memory_order_relaxed); }
+
+		void Put(int64_t i, T* item)
+		{ slots[i & mask].store(item, std::memory_order::memory_order_relaxed); }
+
+		const int64_t capacity;
+		const int64_t mask;
+		std::unique_ptr<std::atomic<T*>[]> slots;
+	};
+
+	Buffer* Grow(Buffer* old, int64_t bottom, int64_t top);
+
+private:
+	alignas(64) std::atomic<int64_t> top_ {0};
+	alignas(64) std::atomic<int64_t> bottom_ {0};
+	std::atomic<Buffer*> buffer_;
+	/// @brief 所有分配过的缓冲区，仅所有者线程访问
+	std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t capacity) {
+	size_t cap = 1;
+	while (cap < capacity) {
+		cap <<= 1;
+	}
+	buffers_.emplace_back(new Buffer(cap));
+	buffer_.store(buffers_.back().get(), std::memory_order::memory_order_relaxed);
+}
+
+template <typename T>
+void WorkStealingDeque<T>::Push(T* item) {
+	int64_t b = bottom_.load(std::memory_order::memory_order_relaxed);
+	int64_t t = top_.load(std::memory_order::memory_order_acquire);
+	Buffer* buf = buffer_.load(std::memory_order::memory_order_relaxed);
+
+	if (b - t > buf->capacity - 1) {
+		buf = Grow(buf, b, t);
+	}
+
+	buf->Put(b, item);
+	std::atomic_thread_fence(std::memory_order::memory_order_release);
+	bottom_.store(b + 1, std::memory_order::memory_order_relaxed);
+}
+
+template <typename T>
+T* WorkStealingDeque<T>::Pop() {
+	int64_t b = bottom_.load(std::memory_order::memory_order_relaxed) - 1;
+	Buffer* buf = buffer_.load(std::memory_order::memory_order_relaxed);
+	bottom_.store(b, std::memory_order::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);
+	int64_t t = top_.load(std::memory_order::memory_order_relaxed);
+
+	T* item = nullptr;
+	if (t <= b) {
+		item = buf->Get(b);
+		if (t == b) {
+			// 最后一个元素，与窃取者竞争
+			if (!top_.compare_exchange_strong(t, t + 1,
+					std::memory_order::memory_order_seq_cst,
+					std::memory_order::memory_order_relaxed))
+			{
+				item = nullptr;
+			}
+			bottom_.store(b + 1, std::memory_order::memory_order_relaxed);
+		}
+	} else {
+		bottom_.store(b + 1, std::memory_order::memory_order_relaxed);
+	}
+	return item;
+}
+
+template <typename T>
+T* WorkStealingDeque<T>::Steal() {
+	int64_t t = top_.load(std::memory_order::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);
+	int64_t b = bottom_.load(std::memory_order::memory_order_acquire);
+
+	if (t < b) {
+		Buffer* buf = buffer_.load(std::memory_order::memory_order_acquire);
+		T* item = buf->Get(t);
+		if (!top_.compare_exchange_strong(t, t + 1,
+				std::memory_order::memory_order_seq_cst,
+				std::memory_order::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+		return item;
+	}
+	return nullptr;
+}
+
+template <typename T>
+typename WorkStealingDeque<T>::Buffer* WorkStealingDeque<T>::Grow(Buffer* old, int64_t bottom, int64_t top) {
+	buffers_.emplace_back(new Buffer(static_cast<size_t>(old->capacity) << 1));
+	Buffer* buf = buffers_.back().get();
+	for (int64_t i = top; i < bottom; ++i) {
+		buf->Put(i, old->Get(i));
+	}
+	buffer_.store(buf, std::memory_order::memory_order_release);
+	return buf;
+}
+
+} // namespace concurrency
+} // namespace sylar